@@ -18,6 +18,56 @@ namespace Porto {
 
 static const char PortoSocket[] = "/run/portod.socket";
 
+/* Receives data and keeps file descriptor passed as SCM_RIGHTS */
+class SocketInputStream : public google::protobuf::io::CopyingInputStream {
+public:
+    int Fd;
+    int Errno = 0;
+    int PassedFd = -1;
+
+    SocketInputStream(int fd) : Fd(fd) { }
+
+    ~SocketInputStream() {
+        if (PassedFd >= 0)
+            close(PassedFd);
+    }
+
+    int Read(void *buffer, int size) override {
+        char control[CMSG_SPACE(sizeof(int))];
+        struct iovec iov;
+        struct msghdr msg;
+        ssize_t ret;
+
+        iov.iov_base = buffer;
+        iov.iov_len = size;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        do
+            ret = recvmsg(Fd, &msg, MSG_CMSG_CLOEXEC);
+        while (ret < 0 && errno == EINTR);
+
+        if (ret < 0) {
+            Errno = errno;
+            return -1;
+        }
+
+        for (auto cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level == SOL_SOCKET &&
+                    cmsg->cmsg_type == SCM_RIGHTS) {
+                if (PassedFd >= 0)
+                    close(PassedFd);
+                PassedFd = *(int *)CMSG_DATA(cmsg);
+            }
+        }
+
+        return ret;
+    }
+};
+
 class Connection::ConnectionImpl {
 public:
     int Fd = -1;
@@ -33,6 +83,8 @@ public:
     int LastError = 0;
     std::string LastErrorMsg;
 
+    int PassedFd = -1;
+
     int Error(int err, const std::string &prefix) {
         LastError = EError::Unknown;
         LastErrorMsg = std::string(prefix + ": " + strerror(err));
@@ -54,11 +106,24 @@ public:
         if (Fd >= 0)
             close(Fd);
         Fd = -1;
+        ClosePassedFd();
+    }
+
+    void ClosePassedFd() {
+        if (PassedFd >= 0)
+            close(PassedFd);
+        PassedFd = -1;
     }
 
     int Send();
     int Recv();
     int Rpc();
+
+    void BatchResults(std::map<std::string, BatchResult> &result) {
+        result.clear();
+        for (auto &res: Rsp.batch().result())
+            result[res.name()] = BatchResult{res.error(), res.errormsg()};
+    }
 };
 
 int Connection::ConnectionImpl::Connect()
@@ -134,28 +199,34 @@ int Connection::ConnectionImpl::Send() {
 }
 
 int Connection::ConnectionImpl::Recv() {
-    google::protobuf::io::FileInputStream raw(Fd);
+    SocketInputStream sock(Fd);
+    google::protobuf::io::CopyingInputStreamAdaptor raw(&sock);
     google::protobuf::io::CodedInputStream input(&raw);
 
+    ClosePassedFd();
+
     while (true) {
         uint32_t size;
 
         if (!input.ReadVarint32(&size))
-            return Error(raw.GetErrno() ?: EIO, "recv");
+            return Error(sock.Errno ?: EIO, "recv");
 
         auto prev_limit = input.PushLimit(size);
 
         Rsp.Clear();
         if (!Rsp.ParseFromCodedStream(&input))
-            return Error(raw.GetErrno() ?: EIO, "recv");
+            return Error(sock.Errno ?: EIO, "recv");
 
         input.PopLimit(prev_limit);
 
         if (Rsp.has_asyncwait()) {
             if (AsyncWaitCallback)
                 AsyncWaitCallback(Rsp.asyncwait().name(), Rsp.asyncwait().state(), Rsp.asyncwait().when());
-        } else
+        } else {
+            PassedFd = sock.PassedFd;
+            sock.PassedFd = -1;
             return EError::Success;
+        }
     }
 }
 
@@ -378,6 +449,23 @@ int Connection::Start(const std::string &name) {
     return Impl->Rpc();
 }
 
+int Connection::StartBatch(const std::vector<std::string> &names,
+                           std::map<std::string, BatchResult> &result,
+                           bool subtree) {
+    auto req = Impl->Req.mutable_startbatch();
+
+    for (auto &name: names)
+        req->add_name(name);
+    if (subtree)
+        req->set_subtree(true);
+
+    int ret = Impl->Rpc();
+    if (!ret)
+        Impl->BatchResults(result);
+
+    return ret;
+}
+
 int Connection::Stop(const std::string &name, int timeout) {
     auto stop = Impl->Req.mutable_stop();
 
@@ -388,6 +476,37 @@ int Connection::Stop(const std::string &name, int timeout) {
     return Impl->Rpc();
 }
 
+int Connection::StopBatch(const std::vector<std::string> &names,
+                          std::map<std::string, BatchResult> &result,
+                          int timeout) {
+    auto req = Impl->Req.mutable_stopbatch();
+
+    for (auto &name: names)
+        req->add_name(name);
+    if (timeout >= 0)
+        req->set_timeout_ms(timeout * 1000);
+
+    int ret = Impl->Rpc();
+    if (!ret)
+        Impl->BatchResults(result);
+
+    return ret;
+}
+
+int Connection::DestroyBatch(const std::vector<std::string> &names,
+                             std::map<std::string, BatchResult> &result) {
+    auto req = Impl->Req.mutable_destroybatch();
+
+    for (auto &name: names)
+        req->add_name(name);
+
+    int ret = Impl->Rpc();
+    if (!ret)
+        Impl->BatchResults(result);
+
+    return ret;
+}
+
 int Connection::Kill(const std::string &name, int sig) {
     Impl->Req.mutable_kill()->set_name(name);
     Impl->Req.mutable_kill()->set_sig(sig);
@@ -650,12 +769,15 @@ int Connection::RemoveLayer(const std::string &layer, const std::string &place)
 
 int Connection::ListLayers(std::vector<Layer> &layers,
                            const std::string &place,
-                           const std::string &mask) {
+                           const std::string &mask,
+                           bool space_usage) {
     auto req = Impl->Req.mutable_listlayers();
     if (place.size())
         req->set_place(place);
     if (mask.size())
         req->set_mask(mask);
+    if (space_usage)
+        req->set_space_usage(true);
     int ret = Impl->Rpc();
     if (!ret) {
         if (Impl->Rsp.layers().layers().size()) {
@@ -666,6 +788,8 @@ int Connection::ListLayers(std::vector<Layer> &layers,
                 l.OwnerGroup = layer.owner_group();
                 l.PrivateValue = layer.private_value();
                 l.LastUsage = layer.last_usage();
+                l.SpaceUsed = layer.space_used();
+                l.SpaceShared = layer.space_shared();
                 layers.push_back(l);
             }
         } else {
@@ -804,4 +928,24 @@ int Connection::LocateProcess(int pid, const std::string &comm,
     return ret;
 }
 
+int Connection::OpenStream(const std::string &name, const std::string &stream,
+                           int &fd, uint64_t &offset) {
+    Impl->Req.mutable_openstream()->set_name(name);
+    Impl->Req.mutable_openstream()->set_stream(stream);
+
+    int ret = Impl->Rpc();
+
+    if (ret)
+        return ret;
+
+    if (Impl->PassedFd < 0)
+        return Impl->Error(EBADF, "no file descriptor in response");
+
+    fd = Impl->PassedFd;
+    Impl->PassedFd = -1;
+    offset = Impl->Rsp.openstream().offset();
+
+    return ret;
+}
+
 } /* namespace Porto */
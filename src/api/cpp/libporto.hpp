@@ -40,6 +40,8 @@ struct Layer {
     std::string OwnerGroup;
     std::string PrivateValue;
     uint64_t LastUsage;
+    uint64_t SpaceUsed = 0;
+    uint64_t SpaceShared = 0;
 };
 
 struct Storage {
@@ -56,6 +58,11 @@ struct GetResponse {
     std::string ErrorMsg;
 };
 
+struct BatchResult {
+    int Error;
+    std::string ErrorMsg;
+};
+
 enum GetFlags {
     NonBlock = 1,
     Sync = 2,
@@ -86,7 +93,17 @@ public:
     int Destroy(const std::string &name);
 
     int Start(const std::string &name);
+    /* parents first, siblings in parallel, with subtree also stopped descendants */
+    int StartBatch(const std::vector<std::string> &names,
+                   std::map<std::string, BatchResult> &result,
+                   bool subtree = false);
     int Stop(const std::string &name, int timeout = -1);
+    /* whole subtrees, siblings in parallel */
+    int StopBatch(const std::vector<std::string> &names,
+                  std::map<std::string, BatchResult> &result,
+                  int timeout = -1);
+    int DestroyBatch(const std::vector<std::string> &names,
+                     std::map<std::string, BatchResult> &result);
     int Kill(const std::string &name, int sig);
     int Pause(const std::string &name);
     int Resume(const std::string &name);
@@ -160,7 +177,8 @@ public:
     int RemoveLayer(const std::string &layer, const std::string &place = "");
     int ListLayers(std::vector<Layer> &layers,
                    const std::string &place = "",
-                   const std::string &mask = "");
+                   const std::string &mask = "",
+                   bool space_usage = false);
 
     int GetLayerPrivate(std::string &private_value, const std::string &layer,
                         const std::string &place = "");
@@ -188,6 +206,10 @@ public:
     int AttachThread(const std::string &name,
                      int pid, const std::string &comm);
     int LocateProcess(int pid, const std::string &comm, std::string &name);
+
+    /* Open stdout or stderr, file position + offset is offset in stream */
+    int OpenStream(const std::string &name, const std::string &stream,
+                   int &fd, uint64_t &offset);
 };
 
 } /* namespace Porto */
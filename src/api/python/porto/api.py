@@ -1,5 +1,6 @@
 import os
 import time
+import array
 import socket
 import threading
 
@@ -20,6 +21,7 @@ class _RPC(object):
         self.async_wait_names = []
         self.async_wait_callback = None
         self.async_wait_timeout = None
+        self.passed_fds = None
 
     def _connect(self):
         SOCK_CLOEXEC = 0o2000000
@@ -65,7 +67,15 @@ class _RPC(object):
         msg = bytearray()
         while len(msg) < count:
             self._set_socket_timeout()
-            chunk = self.sock.recv(count - len(msg))
+            if self.passed_fds is None:
+                chunk = self.sock.recv(count - len(msg))
+            else:
+                chunk, ancdata, _, _ = self.sock.recvmsg(count - len(msg), socket.CMSG_SPACE(array.array('i').itemsize))
+                for level, kind, data in ancdata:
+                    if level == socket.SOL_SOCKET and kind == socket.SCM_RIGHTS:
+                        fds = array.array('i')
+                        fds.frombytes(data[:len(data) - len(data) % fds.itemsize])
+                        self.passed_fds.extend(fds)
             if not chunk:
                 raise socket.error(socket.errno.ECONNRESET, os.strerror(socket.errno.ECONNRESET))
             msg.extend(chunk)
@@ -100,8 +110,14 @@ class _RPC(object):
         hdr.append(length)
         return hdr + req
 
-    def call(self, request, call_timeout=0):
+    def _close_passed_fds(self):
+        for fd in self.passed_fds or []:
+            os.close(fd)
+        self.passed_fds = None
+
+    def call(self, request, call_timeout=0, recv_fd=False):
         req = self.encode_request(request)
+        fd = None
 
         with self.lock:
             self._set_deadline(self.timeout)
@@ -121,7 +137,11 @@ class _RPC(object):
                     elif self.deadline is not None:
                         self.deadline += call_timeout
 
+                    if recv_fd:
+                        self.passed_fds = []
                     response = self._recv_response()
+                    if recv_fd and self.passed_fds:
+                        fd = self.passed_fds.pop()
                 except socket.timeout as e:
                     self.sock = None
                     if not self.auto_reconnect:
@@ -132,9 +152,13 @@ class _RPC(object):
                         raise exceptions.SocketError("Socket error: {}".format(e))
                 else:
                     break
+                finally:
+                    self._close_passed_fds()
 
         if response.error != rpc_pb2.Success:
             raise exceptions.PortoException.Create(response.error, response.errorMsg)
+        if recv_fd:
+            return response, fd
         return response
 
     def connect(self, timeout=None):
@@ -252,6 +276,9 @@ class Container(object):
     def SetSymlink(self, symlink, target):
         return self.conn.SetSymlink(self.name, symlink, target)
 
+    def OpenStream(self, stream="stdout"):
+        return self.conn.OpenStream(self.name, stream)
+
     def WaitContainer(self, timeout=None):
         return self.conn.WaitContainers([self.name], timeout=timeout)
 
@@ -275,6 +302,8 @@ class Layer(object):
         self.owner_group = None
         self.last_usage = None
         self.private_value = None
+        self.space_used = None
+        self.space_shared = None
         if pb is not None:
             self.Update(pb)
 
@@ -285,6 +314,9 @@ class Layer(object):
         self.owner_group = pb.owner_group
         self.last_usage = pb.last_usage
         self.private_value = pb.private_value
+        if pb.HasField('space_used'):
+            self.space_used = pb.space_used
+            self.space_shared = pb.space_shared
 
     def __str__(self):
         return self.name
@@ -619,6 +651,36 @@ class Connection(object):
         request.start.name = name
         self.rpc.call(request, timeout)
 
+    def _batch_result(self, response):
+        result = {}
+        for res in response.Batch.result:
+            if res.error != rpc_pb2.Success:
+                result[res.name] = exceptions.PortoException.Create(res.error, res.errorMsg)
+            else:
+                result[res.name] = None
+        return result
+
+    def StartBatch(self, names, subtree=False, timeout=None):
+        request = rpc_pb2.TContainerRequest()
+        request.StartBatch.name.extend([c.name if isinstance(c, Container) else c for c in names])
+        if subtree:
+            request.StartBatch.subtree = True
+        return self._batch_result(self.rpc.call(request, timeout))
+
+    def StopBatch(self, names, timeout=None):
+        request = rpc_pb2.TContainerRequest()
+        request.StopBatch.name.extend([c.name if isinstance(c, Container) else c for c in names])
+        if timeout is not None and timeout >= 0:
+            request.StopBatch.timeout_ms = timeout * 1000
+        else:
+            timeout = 30
+        return self._batch_result(self.rpc.call(request, timeout))
+
+    def DestroyBatch(self, names):
+        request = rpc_pb2.TContainerRequest()
+        request.DestroyBatch.name.extend([c.name if isinstance(c, Container) else c for c in names])
+        return self._batch_result(self.rpc.call(request))
+
     def Stop(self, name, timeout=None):
         request = rpc_pb2.TContainerRequest()
         request.stop.name = name
@@ -934,17 +996,19 @@ class Connection(object):
             request.exportLayer.compress = compress
         self.rpc.call(request, timeout or self.disk_timeout)
 
-    def _ListLayers(self, place=None, mask=None):
+    def _ListLayers(self, place=None, mask=None, space_usage=False):
         request = rpc_pb2.TContainerRequest()
         request.listLayers.CopyFrom(rpc_pb2.TLayerListRequest())
         if place is not None:
             request.listLayers.place = place
         if mask is not None:
             request.listLayers.mask = mask
+        if space_usage:
+            request.listLayers.space_usage = True
         return self.rpc.call(request).layers
 
-    def ListLayers(self, place=None, mask=None):
-        response = self._ListLayers(place, mask)
+    def ListLayers(self, place=None, mask=None, space_usage=False):
+        response = self._ListLayers(place, mask, space_usage)
         if response.layers:
             return [Layer(self, l.name, place, l) for l in response.layers]
         return [Layer(self, l, place) for l in response.layer]
@@ -1062,6 +1126,19 @@ class Connection(object):
         request.SetSymlink.target = target
         self.rpc.call(request)
 
+    # Returns file descriptor and stream offset, position in file + offset is
+    # offset in stream. Rotation collapses head of file and increases offset.
+    def OpenStream(self, name, stream="stdout"):
+        if not hasattr(socket.socket, 'recvmsg'):
+            raise NotImplementedError("socket.recvmsg is required")
+        request = rpc_pb2.TContainerRequest()
+        request.OpenStream.name = name
+        request.OpenStream.stream = stream
+        response, fd = self.rpc.call(request, recv_fd=True)
+        if fd is None:
+            raise exceptions.PortoException.Create(rpc_pb2.Unknown, "no file descriptor in response")
+        return fd, response.OpenStream.offset
+
     def AttachProcess(self, name, pid, comm=""):
         request = rpc_pb2.TContainerRequest()
         request.attachProcess.name = name
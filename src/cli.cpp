@@ -184,6 +184,21 @@ void ICmd::PrintError(const string &str) {
     PrintError(error, str);
 }
 
+int ICmd::PrintErrors(const std::map<std::string, Porto::BatchResult> &result,
+                      const std::string &str) {
+    int ret = 0;
+
+    for (auto &it: result) {
+        if (it.second.Error) {
+            TError error((EError)it.second.Error, it.second.ErrorMsg);
+            PrintError(error, str + " " + it.first);
+            ret = it.second.Error;
+        }
+    }
+
+    return ret;
+}
+
 void ICmd::PrintUsage() {
     std::cout << "Usage: " << program_invocation_short_name
               << " " << Name << " " << Usage << std::endl
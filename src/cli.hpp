@@ -32,6 +32,8 @@ public:
     void PrintPair(const std::string &key, const std::string &val);
     void PrintError(const TError &error, const std::string &str);
     void PrintError(const std::string &str);
+    int PrintErrors(const std::map<std::string, Porto::BatchResult> &result,
+                    const std::string &str);
     void PrintUsage();
     bool ValidArgs(const std::vector<std::string> &args);
     virtual int Execute(TCommandEnviroment *env) = 0;
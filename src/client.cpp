@@ -45,6 +45,19 @@ TClient::~TClient() {
     CloseConnection();
 }
 
+void TClient::CopyIdentity(const TClient &client) {
+    Id = client.Id;
+    Cred = client.Cred;
+    TaskCred = client.TaskCred;
+    Pid = client.Pid;
+    Comm = client.Comm;
+    UserCtGroup = client.UserCtGroup;
+    ClientContainer = client.ClientContainer;
+    AccessLevel = client.AccessLevel;
+    PortoNamespace = client.PortoNamespace;
+    WriteNamespace = client.WriteNamespace;
+}
+
 void TClient::CloseConnection() {
     auto lock = Lock();
 
@@ -277,8 +290,10 @@ TError TClient::LockContainer(std::shared_ptr<TContainer> &ct) {
     auto lock = LockContainers();
     ReleaseContainer(true);
     TError error = ct->LockAction(lock);
-    if (!error)
+    if (!error) {
         LockedContainer = ct;
+        LogContainerId = ct->Id;
+    }
     return error;
 }
 
@@ -286,6 +301,7 @@ void TClient::ReleaseContainer(bool containers_locked) {
     if (LockedContainer) {
         LockedContainer->UnlockAction(containers_locked);
         LockedContainer = nullptr;
+        LogContainerId = 0;
     }
 }
 
@@ -480,7 +496,37 @@ TError TClient::SendResponse(bool first) {
         return OK; /* Connection closed */
 
 next:
-    ssize_t len = send(Fd, &Buffer[Offset], Length - Offset, MSG_DONTWAIT);
+    ssize_t len;
+
+    if (!PassFds.empty() && Offset == PassFds.front().Offset) {
+        /* One descriptor per message, the next one starts its own */
+        uint64_t end = PassFds.size() > 1 ? std::next(PassFds.begin())->Offset : Length;
+        char control[CMSG_SPACE(sizeof(int))] = {0};
+        struct iovec iov;
+        struct msghdr msg;
+
+        iov.iov_base = &Buffer[Offset];
+        iov.iov_len = end - Offset;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        *(int *)CMSG_DATA(cmsg) = PassFds.front().File.Fd;
+
+        len = sendmsg(Fd, &msg, MSG_DONTWAIT);
+        if (len > 0)
+            PassFds.pop_front();
+    } else if (!PassFds.empty() && Offset < PassFds.front().Offset)
+        len = send(Fd, &Buffer[Offset], PassFds.front().Offset - Offset, MSG_DONTWAIT);
+    else
+        len = send(Fd, &Buffer[Offset], Length - Offset, MSG_DONTWAIT);
+
     if (len > 0)
         Offset += len;
     else if (len == 0) {
@@ -494,11 +540,16 @@ next:
 
     ActivityTimeMs = GetCurrentTimeMs();
 
+    /* Send the rest with passed fd */
+    if (len > 0 && !PassFds.empty() && Offset == PassFds.front().Offset && Offset < Length)
+        goto next;
+
     if (Offset >= Length) {
         if (ShutdownPortod && shutdown(Fd, SHUT_RDWR))
             L_ERR("Cannot shutdown client: {}", TError::System("shutdown"));
 
         Length = Offset = 0;
+        PassFds.clear();
 
         if (!ReportQueue.empty()) {
             QueueReport(ReportQueue.front(), true);
@@ -523,7 +574,7 @@ next:
     return TError::Queued();
 }
 
-TError TClient::QueueResponse(rpc::TContainerResponse &response) {
+TError TClient::QueueResponse(rpc::TContainerResponse &response, TFile *fd) {
 
     if (Receiving)
         return TError(EError::Busy, "QueueResponse while Receiving");
@@ -541,6 +592,13 @@ TError TClient::QueueResponse(rpc::TContainerResponse &response) {
     if (!response.SerializeToArray(&Buffer[tail + lengthSize], length))
         return TError("cannot serialize response");
 
+    if (fd && *fd) {
+        PassFds.emplace_back();
+        PassFds.back().Offset = tail;
+        PassFds.back().File.SetFd = fd->Fd;
+        fd->SetFd = -1;
+    }
+
     return OK;
 }
 
@@ -43,6 +43,9 @@ public:
     TClient(const std::string &special);
     ~TClient();
 
+    /* For worker threads acting on behalf of the client */
+    void CopyIdentity(const TClient &client);
+
     std::unique_lock<std::mutex> Lock() {
         return std::unique_lock<std::mutex>(Mutex);
     }
@@ -106,7 +109,7 @@ public:
     TError ReadRequest(rpc::TContainerRequest &request);
     void QueueRequest();
     TError SendResponse(bool first);
-    TError QueueResponse(rpc::TContainerResponse &response);
+    TError QueueResponse(rpc::TContainerResponse &response, TFile *fd = nullptr);
     TError QueueReport(const TContainerReport &report, bool async);
     TError MakeReport(const std::string &name, const std::string &state, bool async);
 
@@ -120,6 +123,13 @@ private:
     uint64_t Offset = 0;
     std::vector<uint8_t> Buffer;
     std::unique_ptr<TRequest> Request;
+
+    /* Passed as SCM_RIGHTS with byte at Offset, in order of responses */
+    struct TPassFd {
+        uint64_t Offset;
+        TFile File;
+    };
+    std::list<TPassFd> PassFds;
 };
 
 extern TClient SystemClient;
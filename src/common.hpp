@@ -89,6 +89,7 @@ constexpr const char *PORTOD_MASTER_NAME = "portod-master";
 constexpr const char *PORTOD_NAME = "portod";
 
 constexpr const char *PORTO_LOG = "/var/log/portod.log";
+constexpr const char *PORTO_BINARY_LOG = "/var/log/portod.binlog";
 
 constexpr const char *PORTO_CONTAINERS_KV = "/run/porto/kvs";
 constexpr const char *PORTO_VOLUMES_KV = "/run/porto/pkvs";
@@ -99,6 +100,7 @@ constexpr const char *PORTO_PLACE = "/place";
 constexpr const char *PORTO_VOLUMES = "porto_volumes";
 constexpr const char *PORTO_LAYERS = "porto_layers";
 constexpr const char *PORTO_STORAGE = "porto_storage";
+constexpr const char *PORTO_CONTENT = "porto_content";
 
 constexpr const char *PORTO_CHROOT_VOLUMES = "porto";
 
@@ -112,5 +114,6 @@ constexpr uint64_t RUN_SUBDIR_LIMIT = 100u;
 constexpr const char *PORTO_NAME_CHARS = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_-@:.";
 
 extern void AckExitStatus(int pid);
+extern void ReapExitStatus(int pid);
 
 extern std::string PreviousVersion;
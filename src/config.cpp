@@ -49,6 +49,7 @@ static void DefaultConfig() {
 
     config().mutable_log()->set_verbose(false);
     config().mutable_log()->set_debug(false);
+    config().mutable_log()->set_binary(false);
 
     config().set_keyvalue_limit(1 << 20);
     config().set_keyvalue_size(32 << 20);
@@ -56,6 +57,8 @@ static void DefaultConfig() {
     config().mutable_daemon()->set_rw_threads(20);
     config().mutable_daemon()->set_ro_threads(10);
     config().mutable_daemon()->set_io_threads(5);
+    config().mutable_daemon()->set_helpers_spawner(true);
+    config().mutable_daemon()->set_pidfd_exit(true);
 
     config().mutable_daemon()->set_max_clients(1000);
     config().mutable_daemon()->set_max_clients_in_container(500);
@@ -109,6 +112,8 @@ static void DefaultConfig() {
 
     config().mutable_container()->set_enable_systemd(true);
     config().mutable_container()->set_detect_systemd(true);
+    config().mutable_container()->set_vfork_spawn(true);
+    config().mutable_container()->set_batch_threads(8);
 
     config().mutable_volumes()->set_enable_quota(true);
 
@@ -118,6 +123,11 @@ static void DefaultConfig() {
     config().mutable_volumes()->set_max_total(3000);
     config().mutable_volumes()->set_place_load_limit("default: 2; /ssd: 4");
     config().mutable_volumes()->set_squashfs_compression("gzip");
+    config().mutable_volumes()->set_checksum_threads(4);
+    config().mutable_volumes()->set_async_remove(true);
+    config().mutable_volumes()->set_remove_threads(2);
+    config().mutable_volumes()->set_remove_tree_threads(4);
+    config().mutable_volumes()->set_loop_pool_size(8);
 
     config().mutable_volumes()->set_owner_container_migration_hack(true); /* FIXME kill it */
 
@@ -138,6 +148,9 @@ static void DefaultConfig() {
     config().mutable_network()->set_proxy_ndp(true);
     config().mutable_network()->set_proxy_ndp_watchdog_ms(60000);
     config().mutable_network()->set_watchdog_ms(5000);
+    config().mutable_network()->set_watchdog_threads(2);
+    config().mutable_network()->set_watchdog_deadline_ms(2000);
+    config().mutable_network()->set_watchdog_backoff_ms(300000);
     config().mutable_network()->set_resolv_conf_watchdog_ms(5000);
 
 
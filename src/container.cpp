@@ -5,6 +5,8 @@
 #include <cstdlib>
 #include <algorithm>
 #include <condition_variable>
+#include <thread>
+#include <set>
 
 #include "portod.hpp"
 #include "container.hpp"
@@ -39,6 +41,7 @@ extern "C" {
 #include <sys/stat.h>
 #include <sys/wait.h>
 #include <sys/vfs.h>
+#include <sys/inotify.h>
 #include <linux/magic.h>
 }
 
@@ -55,6 +58,14 @@ static std::vector<TBitMap> CoreThreads;
 static TBitMap NumaNodes;
 static std::vector<TBitMap> NodeThreads;
 
+static std::mutex RotateMutex;
+static std::multimap<uint64_t, std::weak_ptr<TContainer>> RotateQueue;
+
+/* One-shot inotify watches of idle stdout and stderr */
+static TFile RotateNotify;
+static std::shared_ptr<TEpollSource> RotateSource;
+static std::multimap<int, std::weak_ptr<TContainer>> RotateWatches;
+
 TError TContainer::ValidName(const std::string &name, bool superuser) {
 
     if (name.length() == 0)
@@ -858,6 +869,9 @@ void TContainer::SetState(EContainerState next) {
     if (next == EContainerState::Dead && AutoRespawn)
         ScheduleRespawn();
 
+    if (next == EContainerState::Running && config().daemon().log_rotate_ms())
+        ScheduleRotate(config().daemon().log_rotate_ms());
+
     DowngradeStateLock();
 
     if (prev == EContainerState::Running || next == EContainerState::Running) {
@@ -1861,6 +1875,39 @@ TError TContainer::PrepareOomMonitor() {
     return error;
 }
 
+/* Get exit of task directly from pidfd, before master reports it */
+void TContainer::WatchExit() {
+    static bool unsupported = false;
+    TError error;
+
+    if (!config().daemon().pidfd_exit() || unsupported || !WaitTask.Pid || ExitSource)
+        return;
+
+    ExitFd.SetFd = PidFdOpen(WaitTask.Pid);
+    if (ExitFd.Fd < 0) {
+        if (errno == ENOSYS || errno == EINVAL) {
+            L("Pidfd is not supported, use exit reports from master");
+            unsupported = true;
+        } else
+            L_WRN("Cannot open pidfd for {}: {}", WaitTask.Pid, TError::System("pidfd_open"));
+        return;
+    }
+
+    ExitSource = std::make_shared<TEpollSource>(ExitFd.Fd, EPOLL_EVENT_EXIT, shared_from_this());
+    error = EpollLoop->AddSource(ExitSource);
+    if (error) {
+        L_WRN("Cannot watch exit of {}: {}", WaitTask.Pid, error);
+        UnwatchExit();
+    }
+}
+
+void TContainer::UnwatchExit() {
+    if (ExitSource)
+        EpollLoop->RemoveSource(ExitSource->Fd);
+    ExitSource = nullptr;
+    ExitFd.Close();
+}
+
 TError TContainer::ApplyDeviceConf() const {
     TError error;
 
@@ -2073,6 +2120,14 @@ TError TContainer::PrepareTask(TTaskEnv &TaskEnv) {
 
     TaskEnv.QuadroFork = !OsMode && !IsMeta();
 
+    /*
+     * Without nested pid-namespace intermediate task exits right after clone.
+     * Caller is suspended until then, so streams must not block at open.
+     */
+    TaskEnv.VForkSpawn = !TaskEnv.TripleFork && config().container().vfork_spawn() &&
+        !Stdin.MayBlockOutside(*this) && !Stdout.MayBlockOutside(*this) &&
+        !Stderr.MayBlockOutside(*this);
+
     TaskEnv.Mnt.BindMounts = BindMounts;
     TaskEnv.Mnt.Symlink = Symlink;
 
@@ -2254,6 +2309,8 @@ TError TContainer::StartTask() {
         return OK;
 
     error = TaskEnv.Start();
+    if (!error)
+        WatchExit();
 
     /* Always report OOM stuation if any */
     if (error && RecvOomEvents())
@@ -2287,6 +2344,11 @@ TError TContainer::StartParents() {
         if (error)
             return error;
 
+        /* Might be started by sibling while we waited for lock */
+        if (target->State == EContainerState::Running ||
+                target->State == EContainerState::Meta)
+            continue;
+
         error = target->Start();
         if (error)
             return error;
@@ -2400,6 +2462,101 @@ TError TContainer::PrepareStart() {
     return OK;
 }
 
+/*
+ * Runs action for each container on behalf of current client, with lock
+ * under its own action lock, otherwise caller must hold lock for all of them.
+ * Containers are processed level by level, containers at the same level are
+ * independent and processed in parallel by a pool of threads.
+ * With parents_first children of failed containers are skipped.
+ */
+void TContainer::BatchAction(const std::vector<std::shared_ptr<TContainer>> &cts,
+                             std::vector<TError> &result, bool parents_first, bool lock,
+                             std::function<TError(std::shared_ptr<TContainer> &ct)> action) {
+    std::vector<size_t> order(cts.size());
+    std::set<TContainer *> failed;
+    std::mutex failedMutex;
+    TClient *client = CL;
+
+    result.assign(cts.size(), OK);
+
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return parents_first ? cts[a]->Level < cts[b]->Level :
+                               cts[a]->Level > cts[b]->Level;
+    });
+
+    auto run = [&](TClient &worker, size_t index) {
+        auto ct = cts[index];
+        TError error;
+
+        if (parents_first) {
+            std::lock_guard<std::mutex> guard(failedMutex);
+            for (auto p = ct->Parent; p; p = p->Parent) {
+                if (failed.count(p.get())) {
+                    error = TError(EError::InvalidState, "Parent {} failed", p->Name);
+                    break;
+                }
+            }
+        }
+
+        if (!error && lock)
+            error = worker.LockContainer(ct);
+        if (!error) {
+            error = action(ct);
+            if (lock)
+                worker.ReleaseContainer();
+        }
+
+        if (error) {
+            std::lock_guard<std::mutex> guard(failedMutex);
+            failed.insert(ct.get());
+        }
+
+        result[index] = error;
+    };
+
+    for (size_t begin = 0, end; begin < order.size(); begin = end) {
+        for (end = begin + 1; end < order.size() &&
+                cts[order[end]]->Level == cts[order[begin]]->Level; end++);
+
+        size_t count = end - begin;
+        size_t nr_threads = std::min<size_t>(count, config().container().batch_threads());
+
+        if (nr_threads <= 1) {
+            for (size_t i = begin; i < end; i++)
+                run(*client, order[i]);
+            continue;
+        }
+
+        std::atomic<size_t> next(begin);
+        std::vector<std::thread> threads;
+
+        for (size_t i = 0; i < nr_threads; i++) {
+            threads.emplace_back([&] {
+                TClient worker(-1);
+
+                worker.CopyIdentity(*client);
+                CL = &worker;
+
+                while (1) {
+                    size_t index = next++;
+                    if (index >= end)
+                        break;
+                    run(worker, order[index]);
+                }
+
+                worker.ReleaseContainer();
+                CL = nullptr;
+            });
+        }
+
+        for (auto &thread: threads)
+            thread.join();
+    }
+}
+
 TError TContainer::Start() {
     TError error;
 
@@ -2599,19 +2756,27 @@ void TContainer::FreeRuntimeResources() {
 }
 
 void TContainer::FreeResources() {
-    TError error;
-
     if (IsRoot())
         return;
 
+    RemoveCgroups();
+    FreeVolumes();
+}
+
+/* Touches only own cgroups, could run without lock in parallel with siblings */
+void TContainer::RemoveCgroups() {
     for (auto hy: Hierarchies) {
         if (Controllers & hy->Controllers) {
             auto cg = GetCgroup(*hy);
             (void)cg.Remove(); //Logged inside
         }
     }
+}
 
+/* Volume destruction locks containers, must run on behalf of lock owner */
+void TContainer::FreeVolumes() {
     std::list<std::shared_ptr<TVolume>> unlinked;
+    TError error;
 
     for (auto &link: VolumeLinks) {
         error = link->Volume->UmountLink(link, unlinked);
@@ -2694,6 +2859,7 @@ TError TContainer::Terminate(uint64_t deadline) {
 }
 
 void TContainer::ForgetPid() {
+    UnwatchExit();
     Task.Pid = 0;
     TaskVPid = 0;
     WaitTask.Pid = 0;
@@ -2727,6 +2893,15 @@ TError TContainer::Stop(uint64_t timeout) {
         for (auto it = subtree.rbegin(); it != subtree.rend(); ++it)
             if ((*it)->Isolate && (*it)->WaitTask.Pid)
                 (void)(*it)->WaitTask.Kill(SIGKILL);
+
+        /* Freeze whole subtree at once: nobody could fork while we kill */
+        if (subtree.size() > 1 && (Controllers & CGROUP_FREEZER) &&
+                !FreezerSubsystem.IsFrozen(freezer)) {
+            L_ACT("Freeze subtree of CT{}:{}", Id, Name);
+            error = FreezerSubsystem.Freeze(freezer);
+            if (error)
+                L_WRN("Cannot freeze CT{}:{}: {}", Id, Name, error);
+        }
     }
 
     for (auto &ct : subtree) {
@@ -2751,6 +2926,8 @@ TError TContainer::Stop(uint64_t timeout) {
     if (timeout)
         CL->LockedContainer->UpgradeActionLock();
 
+    std::vector<std::shared_ptr<TContainer>> stopped;
+
     for (auto &ct: subtree) {
         if (ct->State == EContainerState::Stopped)
             continue;
@@ -2781,7 +2958,21 @@ TError TContainer::Stop(uint64_t timeout) {
 
         TNetwork::StopNetwork(*ct);
         ct->FreeRuntimeResources();
-        ct->FreeResources();
+
+        stopped.push_back(ct);
+    }
+
+    /* Remove cgroups: childs first, siblings in parallel */
+    std::vector<TError> result;
+    BatchAction(stopped, result, false, false, [](std::shared_ptr<TContainer> &ct) {
+        if (!ct->IsRoot())
+            ct->RemoveCgroups();
+        return OK;
+    });
+
+    for (auto &ct: stopped) {
+        if (!ct->IsRoot())
+            ct->FreeVolumes();
 
         ct->SetState(EContainerState::Stopped);
 
@@ -2936,6 +3127,133 @@ TError TContainer::MayRespawn() {
     return OK;
 }
 
+void TContainer::ScheduleRotate(uint64_t delay) {
+    uint64_t due = GetCurrentTimeMs() + delay;
+    std::lock_guard<std::mutex> lock(RotateMutex);
+
+    if (RotateDueMs && RotateDueMs <= due)
+        return;
+
+    if (RotateDueMs) {
+        auto range = RotateQueue.equal_range(RotateDueMs);
+        for (auto it = range.first; it != range.second; it++) {
+            if (it->second.lock().get() == this) {
+                RotateQueue.erase(it);
+                break;
+            }
+        }
+    }
+
+    RotateDueMs = due;
+    RotateQueue.emplace(due, shared_from_this());
+}
+
+/* Schedules check at first modification of path */
+bool TContainer::WatchRotate(const TPath &path) {
+    if (!path)
+        return true;
+
+    if (!RotateNotify)
+        return false;
+
+    int wd = inotify_add_watch(RotateNotify.Fd, path.c_str(),
+                               IN_MODIFY | IN_ONESHOT | IN_DONT_FOLLOW);
+    if (wd < 0) {
+        L_VERBOSE("Cannot watch {}: {}", path, TError::System("inotify_add_watch"));
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(RotateMutex);
+    auto range = RotateWatches.equal_range(wd);
+    for (auto it = range.first; it != range.second; it++)
+        if (it->second.lock().get() == this)
+            return true;
+    RotateWatches.emplace(wd, shared_from_this());
+    return true;
+}
+
+void TContainer::StartRotateNotify() {
+    TError error;
+
+    RotateNotify.SetFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (RotateNotify.Fd < 0) {
+        L_WRN("Cannot watch streams for rotation: {}", TError::System("inotify_init1"));
+        return;
+    }
+
+    RotateSource = std::make_shared<TEpollSource>(RotateNotify.Fd, EPOLL_EVENT_ROTATE,
+                                                  std::weak_ptr<TContainer>());
+    error = EpollLoop->AddSource(RotateSource);
+    if (error) {
+        L_WRN("Cannot watch streams for rotation: {}", error);
+        RotateSource = nullptr;
+        RotateNotify.Close();
+    }
+}
+
+/* Modified streams are checked at next rotation tick */
+void TContainer::RotateNotifyEvent(int fd) {
+    std::vector<std::shared_ptr<TContainer>> modified;
+    char buf[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+    ssize_t len;
+
+    std::unique_lock<std::mutex> lock(RotateMutex);
+    while ((len = read(fd, buf, sizeof(buf))) > 0) {
+        for (char *ptr = buf; ptr < buf + len; ) {
+            auto event = (struct inotify_event *)ptr;
+            auto range = RotateWatches.equal_range(event->wd);
+            for (auto it = range.first; it != range.second; it++) {
+                auto ct = it->second.lock();
+                if (ct && (event->mask & IN_MODIFY))
+                    modified.push_back(ct);
+            }
+            RotateWatches.erase(range.first, range.second);
+            ptr += sizeof(struct inotify_event) + event->len;
+        }
+    }
+    lock.unlock();
+
+    for (auto &ct: modified)
+        ct->ScheduleRotate(0);
+}
+
+/* Rotate stdout and stderr which are due, returns delay for next check */
+uint64_t TContainer::RotateStreams(uint64_t period) {
+    std::vector<std::shared_ptr<TContainer>> due;
+    uint64_t now = GetCurrentTimeMs();
+
+    std::unique_lock<std::mutex> lock(RotateMutex);
+    while (!RotateQueue.empty() && RotateQueue.begin()->first <= now) {
+        auto ct = RotateQueue.begin()->second.lock();
+        if (ct) {
+            ct->RotateDueMs = 0;
+            due.push_back(ct);
+        }
+        RotateQueue.erase(RotateQueue.begin());
+    }
+    lock.unlock();
+
+    for (auto &ct: due) {
+        if (ct->State != EContainerState::Running)
+            continue;
+        ct->Stdout.Rotate(*ct);
+        ct->Stderr.Rotate(*ct);
+        uint64_t delay = std::min(ct->Stdout.RotateDelayMs, ct->Stderr.RotateDelayMs);
+        /* Idle streams wait for modification, timer is only a fallback */
+        if (ct->Stdout.RotateIdle && ct->Stderr.RotateIdle &&
+                ct->WatchRotate(ct->Stdout.RotatePath) &&
+                ct->WatchRotate(ct->Stderr.RotatePath))
+            delay = period * 10;
+        ct->ScheduleRotate(delay);
+    }
+
+    now = GetCurrentTimeMs();
+    lock.lock();
+    if (!RotateQueue.empty() && RotateQueue.begin()->first < now + period)
+        return RotateQueue.begin()->first - std::min(now, RotateQueue.begin()->first);
+    return period;
+}
+
 TError TContainer::ScheduleRespawn() {
     TError error = MayRespawn();
     if (!error) {
@@ -3429,7 +3747,8 @@ void TContainer::SyncState() {
                 L("Cannot seize reparented task: {}", error);
                 Reap(false);
             }
-        }
+        } else
+            WatchExit();
     }
 
     switch (Parent ? Parent->State : EContainerState::Meta) {
@@ -3547,6 +3866,8 @@ void TContainer::Event(const TEvent &event) {
     auto lock = LockContainers();
     auto ct = event.Container.lock();
 
+    LogContainerId = ct ? ct->Id : 0;
+
     switch (event.Type) {
     case EEventType::OOM:
     {
@@ -3582,6 +3903,8 @@ void TContainer::Event(const TEvent &event) {
             if (!error) {
                 if (ct->WaitTask.Pid == event.Exit.Pid ||
                         ct->SeizeTask.Pid == event.Exit.Pid) {
+                    /* Pending pidfd event must not deliver exit again */
+                    ct->UnwatchExit();
                     ct->Exit(event.Exit.Status, false);
                     delivered = true;
                 }
@@ -3598,6 +3921,30 @@ void TContainer::Event(const TEvent &event) {
         }
         break;
     }
+    case EEventType::TaskExit:
+        if (ct) {
+            error = ct->LockAction(lock);
+            lock.unlock();
+            if (!error) {
+                pid_t pid = ct->WaitTask.Pid;
+                int status;
+
+                if (!ct->ExitSource) {
+                    /* Already delivered by master */
+                } else if (!ct->WaitTask.GetExitStatus(status)) {
+                    ct->Exit(status, false);
+                    ct->UnwatchExit();
+                    ReapExitStatus(pid);
+                    Statistics->PidfdExits++;
+                } else if (ct->WaitTask.Exists() && !ct->WaitTask.IsZombie()) {
+                    /* Stale event from previous task */
+                    EpollLoop->StartInput(ct->ExitSource->Fd);
+                } else
+                    ct->UnwatchExit();
+                ct->UnlockAction();
+            }
+        }
+        break;
     case EEventType::WaitTimeout:
     {
         auto waiter = event.WaitTimeout.Waiter.lock();
@@ -3634,21 +3981,27 @@ void TContainer::Event(const TEvent &event) {
         break;
 
     case EEventType::RotateLogs:
+    {
+        static uint64_t agingDeadline = 0;
+        uint64_t period = config().daemon().log_rotate_ms();
+
         lock.unlock();
-        for (auto &ct: RootContainer->Subtree()) {
-            if (ct->State == EContainerState::Dead &&
-                    GetCurrentTimeMs() >= ct->DeathTime + ct->AgingTime) {
-                TEvent ev(EEventType::DestroyAgedContainer, ct);
-                EventQueue->Add(0, ev);
-            }
-            if (ct->State == EContainerState::Running) {
-                ct->Stdout.Rotate(*ct);
-                ct->Stderr.Rotate(*ct);
+        if (GetCurrentTimeMs() >= agingDeadline) {
+            agingDeadline = GetCurrentTimeMs() + period;
+            for (auto &ct: RootContainer->Subtree()) {
+                if (ct->State == EContainerState::Dead &&
+                        GetCurrentTimeMs() >= ct->DeathTime + ct->AgingTime) {
+                    TEvent ev(EEventType::DestroyAgedContainer, ct);
+                    EventQueue->Add(0, ev);
+                }
             }
         }
-        EventQueue->Add(config().daemon().log_rotate_ms(), event);
+        EventQueue->Add(RotateStreams(period), event);
         break;
     }
+    }
+
+    LogContainerId = 0;
 }
 
 std::string TContainer::GetPortoNamespace(bool write) const {
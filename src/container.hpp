@@ -6,6 +6,7 @@
 #include <memory>
 #include <atomic>
 #include <condition_variable>
+#include <functional>
 
 #include "util/unix.hpp"
 #include "util/log.hpp"
@@ -67,6 +68,9 @@ class TContainer : public std::enable_shared_from_this<TContainer>,
 
     std::shared_ptr<TEpollSource> Source;
 
+    TFile ExitFd;
+    std::shared_ptr<TEpollSource> ExitSource;
+
     // data
     TError UpdateSoftLimit();
     void SetState(EContainerState next);
@@ -78,11 +82,15 @@ class TContainer : public std::enable_shared_from_this<TContainer>,
     TError ApplyDynamicProperties();
     TError PrepareOomMonitor();
     void ShutdownOom();
+    void WatchExit();
+    void UnwatchExit();
     TError PrepareCgroups();
     TError PrepareTask(TTaskEnv &TaskEnv);
 
     TError PrepareResources();
     void FreeResources();
+    void RemoveCgroups();
+    void FreeVolumes();
 
     TError PrepareRuntimeResources();
     void FreeRuntimeResources();
@@ -219,6 +227,13 @@ public:
     TError Respawn();
     TError ScheduleRespawn();
 
+    uint64_t RotateDueMs = 0;
+    void ScheduleRotate(uint64_t delay);
+    bool WatchRotate(const TPath &path);
+    static uint64_t RotateStreams(uint64_t period);
+    static void StartRotateNotify();
+    static void RotateNotifyEvent(int fd);
+
     std::string Private;
     EAccessLevel AccessLevel;
     std::atomic<int> ClientsCount;
@@ -403,6 +418,10 @@ public:
     static TError Restore(const TKeyValue &kv, std::shared_ptr<TContainer> &ct);
 
     static void Event(const TEvent &event);
+
+    static void BatchAction(const std::vector<std::shared_ptr<TContainer>> &cts,
+                            std::vector<TError> &result, bool parents_first, bool lock,
+                            std::function<TError(std::shared_ptr<TContainer> &ct)> action);
 };
 
 extern std::mutex ContainersMutex;
@@ -7,6 +7,9 @@
 #include "util/locks.hpp"
 
 constexpr int EPOLL_EVENT_OOM = 1;
+constexpr int EPOLL_EVENT_NET = 2;
+constexpr int EPOLL_EVENT_EXIT = 4;
+constexpr int EPOLL_EVENT_ROTATE = 8;
 
 class TContainer;
 class TEpollLoop;
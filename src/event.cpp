@@ -54,6 +54,8 @@ std::string TEvent::GetMsg() const {
         case EEventType::Exit:
             return "exit status " + std::to_string(Exit.Status)
                 + " for pid " + std::to_string(Exit.Pid);
+        case EEventType::TaskExit:
+            return "task exit";
         case EEventType::RotateLogs:
             return "rotate logs";
         case EEventType::Respawn:
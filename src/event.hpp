@@ -11,6 +11,7 @@ class TContainerWaiter;
 enum class EEventType {
     Exit,
     ChildExit,
+    TaskExit,
     RotateLogs,
     Respawn,
     OOM,
@@ -1,15 +1,23 @@
 #include "helpers.hpp"
 #include "common.hpp"
+#include "config.hpp"
 #include "util/path.hpp"
 #include "util/log.hpp"
 #include "util/unix.hpp"
+#include "util/signal.hpp"
+#include "util/string.hpp"
+#include "client.hpp"
 
 extern "C" {
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <poll.h>
 #include <linux/loop.h>
+#include <linux/fs.h>
 }
 
 static void HelperError(TFile &err, const std::string &text, TError error) {
@@ -18,44 +26,13 @@ static void HelperError(TFile &err, const std::string &text, TError error) {
     _exit(EXIT_FAILURE);
 }
 
-TError RunCommand(const std::vector<std::string> &command,
-                  const TFile &dir, const TFile &in, const TFile &out,
-                  const TCapabilities &caps) {
+/* Setup and exec helper in forked child */
+static void RunHelper(const std::vector<std::string> &command,
+                      const TFile &dir, const TFile &in, const TFile &out,
+                      TFile &err, const TCapabilities &caps) {
     TCgroup memcg = MemorySubsystem.Cgroup(PORTO_HELPERS_CGROUP);
-    TError error;
-    TFile err;
-    TTask task;
     TPath path = dir.RealPath();
-
-    if (!command.size())
-        return TError("External command is empty");
-
-    error = err.CreateUnnamed("/tmp", O_APPEND);
-    if (error)
-        return error;
-
-    std::string cmdline;
-
-    for (auto &arg : command)
-        cmdline += arg + " ";
-
-    L_ACT("Call helper: {} in {}", cmdline, path);
-
-    error = task.Fork();
-    if (error)
-        return error;
-
-    if (task.Pid) {
-        error = task.Wait();
-        if (error) {
-            std::string text;
-            TError error2 = err.ReadEnds(text, TError::MAX - 1024);
-            if (error2)
-                text = "Cannot read stderr: " + error2.ToString();
-            error = TError(error, "helper: {} stderr: {}", cmdline, text);
-        }
-        return error;
-    }
+    TError error;
 
     error = memcg.Attach(GetPid());
     if (error)
@@ -63,6 +40,10 @@ TError RunCommand(const std::vector<std::string> &command,
 
     SetDieOnParentExit(SIGKILL);
 
+    /* Own process group: cancel kills helper with all its childs */
+    if (setpgid(0, 0))
+        HelperError(err, "setpgid", TError::System("setpgid"));
+
     if (!in) {
         TFile in;
         error = in.Open("/dev/null", O_RDONLY);
@@ -135,6 +116,424 @@ TError RunCommand(const std::vector<std::string> &command,
     HelperError(err, fmt::format("Cannot execute {}", argv[0]), TError::System("exec"));
 }
 
+/*
+ * Helper spawner is forked at start while portod is still small, so forks
+ * for helpers don't depend on portod size and threads. Each request comes
+ * in its own socket, spawner forks waiter which receives command and fds,
+ * forks helper and reports its exit status.
+ */
+
+enum {
+    SPAWN_DIR = 1,
+    SPAWN_IN = 2,
+    SPAWN_OUT = 4,
+};
+
+static std::mutex SpawnerMutex;
+static TUnixSocket SpawnerSock;
+static TTask SpawnerTask;
+
+static void HelperWaiter(TUnixSocket &sock) {
+    std::vector<std::string> command;
+    TFile dir, in, out, err;
+    TCapabilities caps;
+    std::string str;
+    int mask, argc, status;
+    TError error;
+
+    Signal(SIGCHLD, SIG_DFL);
+
+    error = sock.RecvInt(mask);
+    if (!error)
+        error = sock.RecvFd(err.SetFd);
+    if (!error && (mask & SPAWN_DIR))
+        error = sock.RecvFd(dir.SetFd);
+    if (!error && (mask & SPAWN_IN))
+        error = sock.RecvFd(in.SetFd);
+    if (!error && (mask & SPAWN_OUT))
+        error = sock.RecvFd(out.SetFd);
+    if (!error)
+        error = sock.RecvString(str);
+    if (!error)
+        error = StringToUint64(str, caps.Permitted);
+    if (!error)
+        error = sock.RecvInt(argc);
+    for (int i = 0; !error && i < argc; i++) {
+        error = sock.RecvString(str);
+        command.push_back(str);
+    }
+    if (error) {
+        sock.SendError(error);
+        _exit(EXIT_FAILURE);
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        sock.SendError(TError::System("fork"));
+        _exit(EXIT_FAILURE);
+    }
+
+    if (!pid) {
+        sock.Close();
+        RunHelper(command, dir, in, out, err, caps);
+    }
+
+    sock.SendError(OK);
+
+    /* Kill helper if portod closes request */
+    int pidfd = PidFdOpen(pid);
+    while (true) {
+        struct pollfd fds[2] = {
+            { sock.GetFd(), POLLRDHUP, 0 },
+            { pidfd, POLLIN, 0 },
+        };
+        siginfo_t info;
+
+        if (poll(fds, pidfd >= 0 ? 2 : 1, pidfd >= 0 ? -1 : 100) < 0 && errno != EINTR)
+            break;
+        if (fds[0].revents) {
+            kill(-pid, SIGKILL);
+            kill(pid, SIGKILL);
+            break;
+        }
+        if (pidfd >= 0) {
+            if (fds[1].revents)
+                break;
+        } else {
+            info.si_pid = 0;
+            if (waitid(P_PID, pid, &info, WEXITED | WNOHANG | WNOWAIT) || info.si_pid)
+                break;
+        }
+    }
+
+    struct rusage usage = {};
+    while (wait4(pid, &status, 0, &usage) < 0) {
+        if (errno != EINTR) {
+            status = EXIT_FAILURE << 8;
+            break;
+        }
+    }
+
+    if (!sock.SendInt(status))
+        sock.SendString(fmt::format("{} {} {}",
+                    usage.ru_utime.tv_sec * 1000000ull + usage.ru_utime.tv_usec +
+                    usage.ru_stime.tv_sec * 1000000ull + usage.ru_stime.tv_usec,
+                    usage.ru_inblock, usage.ru_oublock));
+    _exit(EXIT_SUCCESS);
+}
+
+static void HelperSpawner(TUnixSocket &sock) {
+    SetProcessName("portod-spawner");
+    SetDieOnParentExit(SIGKILL);
+    ResetBlockedSignals();
+
+    /* Reap waiters automatically */
+    Signal(SIGCHLD, SIG_IGN);
+
+    TFile::CloseAll({sock.GetFd(), LogFile.Fd});
+
+    while (true) {
+        int fd;
+
+        TError error = sock.RecvFd(fd);
+        if (error)
+            _exit(EXIT_SUCCESS);
+
+        pid_t pid = fork();
+        if (!pid) {
+            TUnixSocket req(fd);
+            sock.Close();
+            HelperWaiter(req);
+        }
+
+        if (pid < 0) {
+            TUnixSocket req(fd);
+            req.SendError(TError::System("fork"));
+        } else
+            close(fd);
+    }
+}
+
+TError StartHelperSpawner() {
+    TUnixSocket sock;
+    TError error;
+
+    if (!config().daemon().helpers_spawner())
+        return OK;
+
+    error = TUnixSocket::SocketPair(SpawnerSock, sock);
+    if (error)
+        return error;
+
+    error = SpawnerTask.Fork();
+    if (error) {
+        SpawnerSock.Close();
+        return error;
+    }
+
+    if (!SpawnerTask.Pid) {
+        SpawnerSock.Close();
+        HelperSpawner(sock);
+    }
+
+    L_SYS("Helper spawner pid {}", SpawnerTask.Pid);
+    return OK;
+}
+
+/* Returns socket which becomes readable when helper exits */
+static TError SpawnHelper(const std::vector<std::string> &command,
+                          const TFile &dir, const TFile &in, const TFile &out,
+                          const TFile &err, const TCapabilities &caps,
+                          TUnixSocket &sock) {
+    TUnixSocket peer;
+    TError error;
+
+    error = TUnixSocket::SocketPair(sock, peer);
+    if (error)
+        return error;
+
+    auto lock = std::unique_lock<std::mutex>(SpawnerMutex);
+    if (SpawnerSock.GetFd() < 0)
+        return TError(EError::NotSupported, "Helper spawner is not running");
+    error = SpawnerSock.SendFd(peer.GetFd());
+    if (error) {
+        L_WRN("Helper spawner is gone: {}", error);
+        SpawnerSock.Close();
+        return TError(EError::NotSupported, "Helper spawner is not running");
+    }
+    lock.unlock();
+
+    peer.Close();
+
+    error = sock.SendInt((dir ? SPAWN_DIR : 0) | (in ? SPAWN_IN : 0) | (out ? SPAWN_OUT : 0));
+    if (!error)
+        error = sock.SendFd(err.Fd);
+    if (!error && dir)
+        error = sock.SendFd(dir.Fd);
+    if (!error && in)
+        error = sock.SendFd(in.Fd);
+    if (!error && out)
+        error = sock.SendFd(out.Fd);
+    if (!error)
+        error = sock.SendString(std::to_string(caps.Permitted));
+    if (!error)
+        error = sock.SendInt(command.size());
+    for (auto &arg: command) {
+        if (!error)
+            error = sock.SendString(arg);
+    }
+    if (error)
+        return error;
+
+    return sock.RecvError();
+}
+
+static TError SpawnedStatus(TUnixSocket &sock, int &status, struct rusage &usage) {
+    std::string str;
+    uint64_t cpu, read, write;
+    TError error;
+
+    error = sock.RecvInt(status);
+    if (error)
+        return error;
+
+    error = sock.RecvString(str);
+    if (error)
+        return error;
+
+    auto vals = SplitString(str, ' ');
+    if (vals.size() != 3 || StringToUint64(vals[0], cpu) ||
+            StringToUint64(vals[1], read) || StringToUint64(vals[2], write))
+        return TError(EError::Unknown, "Wrong helper usage: {}", str);
+
+    usage.ru_utime.tv_sec = cpu / 1000000;
+    usage.ru_utime.tv_usec = cpu % 1000000;
+    usage.ru_inblock = read;
+    usage.ru_oublock = write;
+    return OK;
+}
+
+/*
+ * Running helper is tracked without blocking in wait: exit is reported via
+ * pidfd or spawner socket, stderr is read from pipe and logged as it comes.
+ * Helper is killed if it's cancellable and requesting client has gone.
+ */
+class THelperJob {
+public:
+    std::string Name;
+    TFile Err;
+    TFile Conn;
+    std::string Stderr;
+    std::string Line;
+    bool Canceled = false;
+
+    void ReadStderr();
+    TError Wait(int exitFd, pid_t pid);
+};
+
+void THelperJob::ReadStderr() {
+    char buf[4096];
+    ssize_t len;
+
+    while ((len = read(Err.Fd, buf, sizeof(buf))) > 0) {
+        Stderr.append(buf, len);
+        if (Stderr.size() > TError::MAX - 1024)
+            Stderr.erase(0, Stderr.size() - (TError::MAX - 1024));
+
+        Line.append(buf, len);
+        std::string::size_type pos;
+        while ((pos = Line.find('\n')) != std::string::npos) {
+            L_VERBOSE("{}: {}", Name, Line.substr(0, pos));
+            Line.erase(0, pos + 1);
+        }
+    }
+
+    if (!len)
+        Err.Close();
+}
+
+/* Without exitFd child is checked periodically */
+TError THelperJob::Wait(int exitFd, pid_t pid) {
+    while (true) {
+        struct pollfd fds[3];
+        int nr = 0;
+
+        fds[nr++] = { exitFd, POLLIN, 0 };
+        if (Err)
+            fds[nr++] = { Err.Fd, POLLIN, 0 };
+        if (Conn)
+            fds[nr++] = { Conn.Fd, POLLRDHUP, 0 };
+
+        if (poll(fds, nr, exitFd >= 0 ? -1 : 100) < 0) {
+            if (errno == EINTR)
+                continue;
+            return TError::System("poll");
+        }
+
+        for (int i = 1; i < nr; i++) {
+            if (fds[i].fd == Err.Fd && fds[i].revents)
+                ReadStderr();
+            else if (fds[i].fd == Conn.Fd && fds[i].revents) {
+                L_ACT("Cancel {}: client is gone", Name);
+                Canceled = true;
+                return OK;
+            }
+        }
+
+        if (exitFd >= 0) {
+            if (fds[0].revents)
+                return OK;
+        } else {
+            siginfo_t info;
+
+            info.si_pid = 0;
+            if (waitid(P_PID, pid, &info, WEXITED | WNOHANG | WNOWAIT) || info.si_pid)
+                return OK;
+        }
+    }
+}
+
+TError RunCommand(const std::vector<std::string> &command,
+                  const TFile &dir, const TFile &in, const TFile &out,
+                  const TCapabilities &caps, bool cancellable) {
+    struct rusage usage = {};
+    THelperJob job;
+    TFile err;
+    TUnixSocket sock;
+    TTask task;
+    TError error;
+    TPath path = dir.RealPath();
+    int status = 0;
+
+    if (!command.size())
+        return TError("External command is empty");
+
+    int pfd[2];
+    if (pipe2(pfd, O_CLOEXEC))
+        return TError::System("pipe2");
+    job.Err.SetFd = pfd[0];
+    err.SetFd = pfd[1];
+
+    if (fcntl(job.Err.Fd, F_SETFL, O_NONBLOCK))
+        return TError::System("fcntl");
+
+    if (cancellable && CL && CL->Fd >= 0) {
+        auto lock = CL->Lock();
+        if (CL->Fd >= 0)
+            job.Conn.SetFd = fcntl(CL->Fd, F_DUPFD_CLOEXEC, 3);
+    }
+
+    std::string cmdline;
+
+    for (auto &arg : command)
+        cmdline += arg + " ";
+
+    job.Name = "helper " + command[0];
+
+    L_ACT("Call helper: {} in {}", cmdline, path);
+    Statistics->HelpersStarted++;
+
+    /* Fork from portod if spawner isn't running */
+    error = SpawnHelper(command, dir, in, out, err, caps, sock);
+    if (error == EError::NotSupported) {
+        error = task.Fork();
+        if (error)
+            return error;
+
+        if (!task.Pid)
+            RunHelper(command, dir, in, out, err, caps);
+
+        err.Close();
+
+        TFile pidfd;
+        pidfd.SetFd = PidFdOpen(task.Pid);
+        error = job.Wait(pidfd.Fd, task.Pid);
+        if (job.Canceled || error) {
+            (void)kill(-task.Pid, SIGKILL);
+            (void)task.Kill(SIGKILL);
+        }
+
+        TError error2 = task.Wait(&usage);
+        if (!error)
+            error = error2;
+        status = task.Status;
+    } else if (!error) {
+        err.Close();
+
+        error = job.Wait(sock.GetFd(), 0);
+        if (!error && !job.Canceled)
+            error = SpawnedStatus(sock, status, usage);
+        if (!error && status)
+            error = TError(EError::Unknown, FormatExitStatus(status));
+        /* Spawner kills helper when request is closed */
+        sock.Close();
+    }
+
+    if (job.Err)
+        job.ReadStderr();
+
+    uint64_t cpu = usage.ru_utime.tv_sec * 1000000ull + usage.ru_utime.tv_usec +
+                   usage.ru_stime.tv_sec * 1000000ull + usage.ru_stime.tv_usec;
+
+    Statistics->HelpersCpuUsage += cpu;
+    Statistics->HelpersReadBytes += usage.ru_inblock * 512ull;
+    Statistics->HelpersWriteBytes += usage.ru_oublock * 512ull;
+
+    if (!job.Canceled)
+        L_ACT("Helper {} exited: {} cpu {} ms read {} write {}", command[0],
+              FormatExitStatus(status), cpu / 1000,
+              StringFormatSize(usage.ru_inblock * 512ull),
+              StringFormatSize(usage.ru_oublock * 512ull));
+
+    if (job.Canceled) {
+        Statistics->HelpersCanceled++;
+        error = TError(EError::Unknown, "helper: {} canceled: client is gone", cmdline);
+    } else if (error)
+        error = TError(error, "helper: {} stderr: {}", cmdline, job.Stderr);
+
+    return error;
+}
+
 TError CopyRecursive(const TPath &src, const TPath &dst) {
     TError error;
     TFile dir;
@@ -148,6 +547,11 @@ TError CopyRecursive(const TPath &src, const TPath &dst) {
                         src.ToString(), "." }, dir);
 }
 
+/*
+ * Trees are removed in portod without helper sandbox: remover works only
+ * with unlinkat relative to directory fds opened with O_NOFOLLOW, never
+ * crosses device or mount boundary and checks inode when goes back up.
+ */
 TError ClearRecursive(const TPath &path) {
     TError error;
     TFile dir;
@@ -156,16 +560,29 @@ TError ClearRecursive(const TPath &path) {
     if (error)
         return error;
 
-    return RunCommand({ "find", ".", "-xdev", "-mindepth", "1", "-delete"}, dir);
+    return dir.ClearDirectory(config().volumes().remove_tree_threads());
 }
 
-TError RemoveRecursive(const TPath &path) {
+TError RemoveRecursive(const TPath &path, const TRemoveVisitor &visit) {
     TError error;
     TFile dir;
 
-    error = dir.OpenDir(path.NormalPath().DirName());
+    if (!path.IsDirectoryStrict())
+        return path.Unlink();
+
+    error = dir.OpenDirStrict(path);
     if (error)
         return error;
 
-    return RunCommand({"rm", "-rf", "--one-file-system", "--", path.ToString()}, dir);
+    error = dir.ClearDirectory(config().volumes().remove_tree_threads(), visit);
+    if (error)
+        return error;
+
+    error = path.Rmdir();
+    if (error && error.Errno == EPERM) {
+        (void)TFile::Chattr(dir.Fd, 0, FS_IMMUTABLE_FL | FS_APPEND_FL);
+        error = path.Rmdir();
+    }
+
+    return error;
 }
@@ -7,7 +7,9 @@ TError RunCommand(const std::vector<std::string> &command,
                   const TFile &dir = TFile(),
                   const TFile &input = TFile(),
                   const TFile &output = TFile(),
-                  const TCapabilities &caps = HelperCapabilities);
+                  const TCapabilities &caps = HelperCapabilities,
+                  bool cancellable = false);
+TError StartHelperSpawner();
 TError CopyRecursive(const TPath &src, const TPath &dst);
 TError ClearRecursive(const TPath &path);
-TError RemoveRecursive(const TPath &path);
+TError RemoveRecursive(const TPath &path, const TRemoveVisitor &visit = nullptr);
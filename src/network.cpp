@@ -8,6 +8,8 @@
 #include "config.hpp"
 #include "client.hpp"
 #include "helpers.hpp"
+#include "epoll.hpp"
+#include "portod.hpp"
 #include "util/log.hpp"
 #include "util/string.hpp"
 #include "util/crc32.hpp"
@@ -19,6 +21,7 @@ extern "C" {
 #include <linux/if_tun.h>
 #include <linux/neighbour.h>
 #include <netlink/cache.h>
+#include <netlink/msg.h>
 #include <netlink/route/link.h>
 #include <netlink/route/tc.h>
 #include <netlink/route/addr.h>
@@ -37,9 +40,12 @@ std::unordered_map<ino_t, std::shared_ptr<TNetwork>> TNetwork::NetworksIndex;
 std::shared_ptr<const std::list<std::shared_ptr<TNetwork>>> TNetwork::NetworksList = std::make_shared<const std::list<std::shared_ptr<TNetwork>>>();
 std::atomic<int> TNetwork::GlobalStatGen;
 
-static std::thread NetThread;
+static std::vector<std::thread> NetThreads;
 static std::condition_variable NetThreadCv;
 static uint64_t NetWatchdogPeriod;
+static uint64_t NetWatchdogDeadline;
+static uint64_t NetWatchdogBackoff;
+static uint64_t NetEventGen = 0; /* Protected with NetworksMutex */
 static uint64_t NetProxyNeighbourPeriod;
 
 static TTuple ResolvConfCurrent;
@@ -309,6 +315,8 @@ void TNetwork::InitializeConfig() {
         StringToUintMap(config().network().ingress_burst(), IngressBurst);
 
     NetWatchdogPeriod = config().network().watchdog_ms();
+    NetWatchdogDeadline = config().network().watchdog_deadline_ms();
+    NetWatchdogBackoff = config().network().watchdog_backoff_ms();
 
     NetProxyNeighbourPeriod = config().network().proxy_ndp_watchdog_ms();
 
@@ -370,6 +378,7 @@ std::string TNetwork::FormatTos(int tos) {
 
 TNetwork::TNetwork() : NatBitmap(0, 0) {
     Nl = std::make_shared<TNl>();
+    NlEvents = std::make_shared<TNl>();
 }
 
 TNetwork::~TNetwork() {
@@ -430,7 +439,8 @@ TError TNetwork::New(TNamespaceFd &netns, std::shared_ptr<TNetwork> &net) {
     if (error) {
         netns.Close();
         net = nullptr;
-    }
+    } else
+        (void)net->ConnectEvents();
 
     TError error2 = curNs.SetNs(CLONE_NEWNET);
     PORTO_ASSERT(!error2);
@@ -478,8 +488,10 @@ TError TNetwork::Open(const TPath &path, TNamespaceFd &netns,
     if (error) {
         netns.Close();
         net = nullptr;
-    } else
+    } else {
+        (void)net->ConnectEvents();
         Register(net, inode);
+    }
 
     TError error2 = curNs.SetNs(CLONE_NEWNET);
     PORTO_ASSERT(!error2);
@@ -509,9 +521,117 @@ void TNetwork::Destroy() {
 
     // TODO: destroy mac/ip-vlan here
 
+    DisconnectEvents();
     Nl->Disconnect();
 }
 
+TError TNetwork::ConnectEvents() {
+    TError error;
+
+    DisconnectEvents();
+
+    error = NlEvents->Connect();
+    if (!error)
+        EventsFd = NlEvents->GetFd();
+    if (!error)
+        error = NlEvents->SubscribeEvents({RTNLGRP_LINK,
+                                           RTNLGRP_IPV4_IFADDR,
+                                           RTNLGRP_IPV6_IFADDR});
+    if (!error) {
+        EventsSource = std::make_shared<TEpollSource>(NlEvents->GetFd(), EPOLL_EVENT_NET,
+                                                      std::weak_ptr<TContainer>());
+        error = EpollLoop->AddSource(EventsSource);
+    }
+
+    if (error) {
+        L_NET("Cannot subscribe network {} events, fallback to polling: {}", NetName, error);
+        DisconnectEvents();
+    }
+
+    return error;
+}
+
+void TNetwork::DisconnectEvents() {
+    if (EventsSource) {
+        EpollLoop->RemoveSource(EventsSource->Fd);
+        EventsSource = nullptr;
+    }
+    EventsFd = -1;
+    NlEvents->Disconnect();
+}
+
+/* Called from main epoll loop, events are handled in watchdog threads */
+void TNetwork::NetlinkEvent(int fd) {
+    EpollLoop->StopInput(fd);
+    auto lock = LockNetworks();
+    for (auto &net: *NetworksList) {
+        if (net->EventsFd == fd) {
+            net->EventsPending = true;
+            NetEventGen++;
+            NetThreadCv.notify_all();
+            break;
+        }
+    }
+}
+
+void TNetwork::HandleEventsLocked() {
+    bool resync = false, links = false;
+    TError error;
+
+    error = NlEvents->RecvEvents([&](struct nl_msg *msg) {
+        struct nlmsghdr *hdr = nlmsg_hdr(msg);
+        struct rtnl_link *link = nullptr;
+
+        if (hdr->nlmsg_type != RTM_NEWLINK && hdr->nlmsg_type != RTM_DELLINK) {
+            links = true;
+            return;
+        }
+
+        if (nl_msg_parse(msg, [](struct nl_object *obj, void *arg) {
+                    nl_object_get(obj);
+                    *(struct rtnl_link **)arg = (struct rtnl_link *)obj;
+                }, &link) < 0 || !link) {
+            resync = true;
+            return;
+        }
+
+        int index = rtnl_link_get_ifindex(link);
+
+        L_NET_VERBOSE("Network {} {} link {}:{}", NetName,
+                      hdr->nlmsg_type == RTM_NEWLINK ? "new" : "del",
+                      index, rtnl_link_get_name(link) ?: "");
+
+        for (auto &dev: Devices)
+            dev.Missing = dev.Index == index;
+
+        if (hdr->nlmsg_type == RTM_NEWLINK)
+            SyncDevice(link);
+
+        ForgetDevices();
+
+        rtnl_link_put(link);
+        links = true;
+    });
+
+    if (error) {
+        L_NET("Resync network {} devices after: {}", NetName, error);
+        resync = true;
+    }
+
+    if (resync) {
+        error = SyncDevices();
+        if (error)
+            StartRepair();
+    }
+
+    /* Proxy neighbours are flushed together with addresses and links */
+    if ((links || resync) && this == HostNetwork.get())
+        RepairProxyNeightbour();
+
+    if (EventsSource)
+        EpollLoop->StartInput(EventsSource->Fd);
+}
+
 TError TNetwork::SetupAddrLabel() {
     TError error;
 
@@ -768,7 +888,6 @@ void TNetwork::SetDeviceOwner(const std::string &name, int owner) {
 
 TError TNetwork::SyncDevices() {
     struct nl_cache *cache;
-    TError error;
     int ret;
 
     ret = rtnl_link_alloc_cache(GetSock(), AF_UNSPEC, &cache);
@@ -778,115 +897,129 @@ TError TNetwork::SyncDevices() {
     for (auto &dev: Devices)
         dev.Missing = true;
 
-    for (auto obj = nl_cache_get_first(cache); obj; obj = nl_cache_get_next(obj)) {
-        auto link = (struct rtnl_link *)obj;
-        int flags = rtnl_link_get_flags(link);
+    for (auto obj = nl_cache_get_first(cache); obj; obj = nl_cache_get_next(obj))
+        SyncDevice((struct rtnl_link *)obj);
 
-        if (flags & IFF_LOOPBACK)
-            continue;
+    nl_cache_free(cache);
 
-        /* Do not setup queue on down links in host namespace */
-        if (!ManagedNamespace && !(flags & IFF_RUNNING))
-            continue;
+    ForgetDevices();
 
-        TNetDevice dev(link);
+    return OK;
+}
 
-        if (DeviceOwners.count(dev.Name))
-            dev.Owner = DeviceOwners.at(dev.Name);
+void TNetwork::SyncDevice(struct rtnl_link *link) {
+    int flags = rtnl_link_get_flags(link);
 
-        if (dev.Type == "veth") {
-            /* Ignore our veth pairs */
-            if (!ManagedNamespace &&
-                    (StringStartsWith(dev.Name, "portove-") ||
-                     StringStartsWith(dev.Name, "L3-")))
-                continue;
+    if (flags & IFF_LOOPBACK)
+        return;
 
-            if (ManagedNamespace)
-                dev.Uplink = true;
-        } else if (dev.Type == "macvlan" || dev.Type == "ipvlan") {
-            if (ManagedNamespace)
-                dev.Uplink = true;
-        } else if (dev.Type == "tun") {
-            /* Ignore TUN/TAP without known owners */
-            if (!dev.Owner)
-                continue;
-        } else if (dev.Type == "dummy") {
-            /* Do not care */
-        } else if (dev.Name == "ip6tnl0") {
-            /* Fallback tunnel for RX only */
-        } else if (ManagedNamespace) {
-            /* No qdisc in containers */
-        } else if (dev.Type == "vlan") {
-            /* TX goes via uplink */
-        } else {
-            dev.Managed = true;
+    /* Do not setup queue on down links in host namespace */
+    if (!ManagedNamespace && !(flags & IFF_RUNNING))
+        return;
 
-            for (auto &pattern: UnmanagedDevices)
-                if (StringMatch(dev.Name, pattern))
-                    dev.Managed = false;
+    TNetDevice dev(link);
 
-            if (std::find(UnmanagedGroups.begin(),
-                          UnmanagedGroups.end(), dev.Group) != UnmanagedGroups.end())
-                dev.Managed = false;
+    if (DeviceOwners.count(dev.Name))
+        dev.Owner = DeviceOwners.at(dev.Name);
+
+    if (dev.Type == "veth") {
+        /* Ignore our veth pairs */
+        if (!ManagedNamespace &&
+                (StringStartsWith(dev.Name, "portove-") ||
+                 StringStartsWith(dev.Name, "L3-")))
+            return;
 
+        if (ManagedNamespace)
             dev.Uplink = true;
-        }
+    } else if (dev.Type == "macvlan" || dev.Type == "ipvlan") {
+        if (ManagedNamespace)
+            dev.Uplink = true;
+    } else if (dev.Type == "tun") {
+        /* Ignore TUN/TAP without known owners */
+        if (!dev.Owner)
+            return;
+    } else if (dev.Type == "dummy") {
+        /* Do not care */
+    } else if (dev.Name == "ip6tnl0") {
+        /* Fallback tunnel for RX only */
+    } else if (ManagedNamespace) {
+        /* No qdisc in containers */
+    } else if (dev.Type == "vlan") {
+        /* TX goes via uplink */
+    } else {
+        dev.Managed = true;
 
-        GetDeviceSpeed(dev);
+        for (auto &pattern: UnmanagedDevices)
+            if (StringMatch(dev.Name, pattern))
+                dev.Managed = false;
 
-        dev.DeviceStat.RxBytes = rtnl_link_get_stat(link, RTNL_LINK_RX_BYTES);
-        dev.DeviceStat.RxPackets = rtnl_link_get_stat(link, RTNL_LINK_RX_PACKETS);
-        dev.DeviceStat.RxDrops = rtnl_link_get_stat(link, RTNL_LINK_RX_DROPPED);
-        dev.DeviceStat.RxOverruns = rtnl_link_get_stat(link, RTNL_LINK_RX_OVER_ERR) +
-                              rtnl_link_get_stat(link, RTNL_LINK_RX_ERRORS);
+        if (std::find(UnmanagedGroups.begin(),
+                      UnmanagedGroups.end(), dev.Group) != UnmanagedGroups.end())
+            dev.Managed = false;
 
-        dev.DeviceStat.TxBytes = rtnl_link_get_stat(link, RTNL_LINK_TX_BYTES);
-        dev.DeviceStat.TxPackets = rtnl_link_get_stat(link, RTNL_LINK_TX_PACKETS);
-        dev.DeviceStat.TxDrops = rtnl_link_get_stat(link, RTNL_LINK_TX_DROPPED);
-        dev.DeviceStat.TxOverruns = rtnl_link_get_stat(link, RTNL_LINK_TX_ERRORS);
+        dev.Uplink = true;
+    }
 
-        auto net_state_lock = LockNetState();
+    GetDeviceSpeed(dev);
 
-        bool found = false;
-        for (auto &d: Devices) {
-            if (d.Name != dev.Name || d.Index != dev.Index)
-                continue;
+    dev.DeviceStat.RxBytes = rtnl_link_get_stat(link, RTNL_LINK_RX_BYTES);
+    dev.DeviceStat.RxPackets = rtnl_link_get_stat(link, RTNL_LINK_RX_PACKETS);
+    dev.DeviceStat.RxDrops = rtnl_link_get_stat(link, RTNL_LINK_RX_DROPPED);
+    dev.DeviceStat.RxOverruns = rtnl_link_get_stat(link, RTNL_LINK_RX_OVER_ERR) +
+                          rtnl_link_get_stat(link, RTNL_LINK_RX_ERRORS);
 
-            if (!d.Managed)
-                dev.Prepared = true;
-            else if (d.Qdisc != dev.GetConfig(DeviceQdisc))
-                L_NET("Missing network {} qdisc at {}:{}", NetName, d.Index, d.Name);
-            else if (d.Rate != dev.Rate || d.Ceil != dev.Ceil)
-                L_NET("Speed changed {}Mbps to {}Mbps in {} at {}:{}",
-                      d.Ceil / 125000, dev.Ceil / 125000, NetName, d.Index, d.Name);
-            else
-                dev.Prepared = true;
+    dev.DeviceStat.TxBytes = rtnl_link_get_stat(link, RTNL_LINK_TX_BYTES);
+    dev.DeviceStat.TxPackets = rtnl_link_get_stat(link, RTNL_LINK_TX_PACKETS);
+    dev.DeviceStat.TxDrops = rtnl_link_get_stat(link, RTNL_LINK_TX_DROPPED);
+    dev.DeviceStat.TxOverruns = rtnl_link_get_stat(link, RTNL_LINK_TX_ERRORS);
 
-            d = dev;
-            found = true;
-            break;
-        }
-        if (!found) {
-            L_NET("New network {} {}managed device {}:{} type={} qdisc={} group={} {} mtu={} speed={}Mbps {}iB/s",
-                    NetName, dev.Managed ? "" : "un",
-                    dev.Index, dev.Name, dev.Type, dev.Qdisc, dev.GroupName,
-                    dev.Uplink ? "uplink" : "", dev.MTU,
-                    dev.Ceil / 125000, StringFormatSize(dev.Ceil));
-            Devices.push_back(dev);
-        }
+    auto net_state_lock = LockNetState();
 
-        if (!dev.Prepared && this == HostNetwork.get()) {
-            RootContainer->NetClass.TxRate[dev.Name] = dev.Rate;
-            RootContainer->NetClass.TxLimit[dev.Name] = dev.Ceil;
-            RootContainer->NetClass.RxLimit[dev.Name] = dev.Ceil;
-        }
+    bool found = false;
+    for (auto &d: Devices) {
+        if (d.Name != dev.Name || d.Index != dev.Index)
+            continue;
 
-        if (!dev.Prepared)
-            StartRepair();
+        if (!d.Managed)
+            dev.Prepared = true;
+        else if (d.Qdisc != dev.GetConfig(DeviceQdisc))
+            L_NET("Missing network {} qdisc at {}:{}", NetName, d.Index, d.Name);
+        else if (d.Rate != dev.Rate || d.Ceil != dev.Ceil)
+            L_NET("Speed changed {}Mbps to {}Mbps in {} at {}:{}",
+                  d.Ceil / 125000, dev.Ceil / 125000, NetName, d.Index, d.Name);
+        else
+            dev.Prepared = true;
+
+        dev.TcStat.swap(d.TcStat);
+        dev.TcPresent.swap(d.TcPresent);
+        d = dev;
+        found = true;
+        break;
+    }
+    if (!found) {
+        StatChanged = true;
+        L_NET("New network {} {}managed device {}:{} type={} qdisc={} group={} {} mtu={} speed={}Mbps {}iB/s",
+                NetName, dev.Managed ? "" : "un",
+                dev.Index, dev.Name, dev.Type, dev.Qdisc, dev.GroupName,
+                dev.Uplink ? "uplink" : "", dev.MTU,
+                dev.Ceil / 125000, StringFormatSize(dev.Ceil));
+        Devices.push_back(dev);
     }
 
-    nl_cache_free(cache);
+    if (!dev.Prepared && this == HostNetwork.get()) {
+        RootContainer->NetClass.TxRate[dev.Name] = dev.Rate;
+        RootContainer->NetClass.TxLimit[dev.Name] = dev.Ceil;
+        RootContainer->NetClass.RxLimit[dev.Name] = dev.Ceil;
+    }
 
+    /* Setup only this device, do not touch others */
+    if (!dev.Prepared && !NetError)
+        NetError = TError::Queued();
+    if (!dev.Prepared)
+        NetThreadCv.notify_all();
+}
+
+void TNetwork::ForgetDevices() {
     auto net_state_lock = LockNetState();
 
     for (auto dev = Devices.begin(); dev != Devices.end(); ) {
@@ -898,15 +1031,9 @@ TError TNetwork::SyncDevices() {
                 RootContainer->NetClass.TxRate.erase(dev->Name);
                 RootContainer->NetClass.TxLimit.erase(dev->Name);
                 RootContainer->NetClass.RxLimit.erase(dev->Name);
-                for (auto cls: NetClasses) {
-                    cls->ClassStat.erase(dev->Name);
-                    for (int cs = 0; cs < NR_TC_CLASSES; cs++) {
-                        auto cs_name = fmt::format("{} CS{}", dev->Name, cs);
-                        cls->ClassStat[fmt::format("Saved CS{}", cs)] += cls->ClassStat[cs_name];
-                        cls->ClassStat.erase(cs_name);
-                    }
-                }
+                SaveDeviceStat(dev->Name);
             }
+            StatChanged = true;
             dev = Devices.erase(dev);
         } else
             dev++;
@@ -919,8 +1046,6 @@ TError TNetwork::SyncDevices() {
         if (dev.Uplink)
             DeviceStat["Uplink"] += dev.DeviceStat;
     }
-
-    return OK;
 }
 
 TError TNetwork::GetGateAddress(std::vector<TNlAddr> addrs,
@@ -1197,7 +1322,7 @@ std::string TNetwork::MatchDevice(const std::string &pattern) {
     return pattern;
 }
 
-TError TNetwork::SetupClass(TNetDevice &dev, TNetClass &cfg, int cs) {
+TError TNetwork::SetupClass(TNetDevice &dev, TNetClass &cfg, int cs, TNlBatch *batch) {
     TError error;
 
     PORTO_LOCKED(NetMutex);
@@ -1230,10 +1355,14 @@ TError TNetwork::SetupClass(TNetDevice &dev, TNetClass &cfg, int cs) {
 
     if (cfg.MetaHandle != cfg.BaseHandle) {
         L_NET_VERBOSE("Setup CS{} meta class {:x} {} {}:{}", cs, cls.Handle, NetName, dev.Index, dev.Name);
-        error = cls.Create(*Nl);
-        if (error) {
-            (void)cls.Delete(*Nl);
+        if (batch) {
+            error = cls.Create(*batch);
+        } else {
             error = cls.Create(*Nl);
+            if (error) {
+                (void)cls.Delete(*Nl);
+                error = cls.Create(*Nl);
+            }
         }
         if (error)
             return TError(error, "tc class");
@@ -1262,6 +1391,13 @@ TError TNetwork::SetupClass(TNetDevice &dev, TNetClass &cfg, int cs) {
 
     L_NET_VERBOSE("Setup CS{} leaf class {:x} {} {}:{}", cs, cls.Handle, NetName, dev.Index, dev.Name);
 
+    if (batch) {
+        error = cls.Create(*batch);
+        if (!error)
+            error = ctq.Create(*batch);
+        return error;
+    }
+
     error = cls.Create(*Nl);
     if (error)
         return TError(error, "leaf tc class");
@@ -1277,6 +1413,62 @@ TError TNetwork::SetupClass(TNetDevice &dev, TNetClass &cfg, int cs) {
     return OK;
 }
 
+/*
+ * Setup classes in one netlink batch, requests which failed or
+ * cannot be batched are retried one by one with recovery.
+ */
+TError TNetwork::SetupClassesBatch(const std::vector<TNetDevice *> &devices,
+                                   const std::vector<TNetClass *> &classes) {
+    struct TEntry {
+        TNetDevice *Dev;
+        TNetClass *Cls;
+        int Cs;
+        size_t First, Last;
+        bool Batched;
+    };
+    std::vector<TEntry> entries;
+    std::vector<TError> errors;
+    TNlBatch batch(*Nl);
+    TError error;
+
+    PORTO_LOCKED(NetMutex);
+    PORTO_LOCKED(NetStateMutex);
+
+    for (auto dev: devices) {
+        for (auto cls: classes) {
+            for (int cs = 0; cs < NR_TC_CLASSES; cs++) {
+                size_t first = batch.Size();
+                error = SetupClass(*dev, *cls, cs, &batch);
+                entries.push_back({dev, cls, cs, first, batch.Size(), !error});
+            }
+        }
+    }
+
+    if (batch.Size()) {
+        L_NET_VERBOSE("Setup {} classes in {} with {} batched requests",
+                      entries.size(), NetName, batch.Size());
+        error = batch.Commit(errors);
+        if (error) {
+            L_NET("Netlink batch failed in {}: {}", NetName, error);
+            for (auto &entry: entries)
+                entry.Batched = false;
+        }
+    }
+
+    for (auto &entry: entries) {
+        bool retry = !entry.Batched;
+        for (size_t i = entry.First; !retry && i < entry.Last; i++)
+            retry = !!errors[i];
+        if (!retry)
+            continue;
+        error = SetupClass(*entry.Dev, *entry.Cls, entry.Cs);
+        if (error)
+            return error;
+    }
+
+    return OK;
+}
+
 TError TNetwork::DeleteClass(TNetDevice &dev, TNetClass &cfg, int cs) {
     TError error;
 
@@ -1305,22 +1497,21 @@ TError TNetwork::DeleteClass(TNetDevice &dev, TNetClass &cfg, int cs) {
     return OK;
 }
 
-TError TNetwork::TrySetupClasses(TNetClass &cls) {
+TError TNetwork::TrySetupClasses(const std::vector<TNetClass *> &classes) {
     auto net_lock = LockNet();
     auto state_lock = LockNetState();
+    std::vector<TNetDevice *> devices;
     TError error;
 
     for (auto &dev: Devices) {
-        if (!dev.Managed || !dev.Prepared)
-            continue;
-
-        for (int cs = 0; cs < NR_TC_CLASSES; cs++) {
-            error = SetupClass(dev, cls, cs);
-            if (error)
-                return error;
-        }
+        if (dev.Managed && dev.Prepared)
+            devices.push_back(&dev);
     }
 
+    error = SetupClassesBatch(devices, classes);
+    if (error)
+        return error;
+
     state_lock.unlock();
     net_lock.unlock();
 
@@ -1328,27 +1519,32 @@ TError TNetwork::TrySetupClasses(TNetClass &cls) {
 }
 
 TError TNetwork::SetupClasses(TNetClass &cls) {
+    return SetupClasses(std::vector<TNetClass *>{&cls});
+}
+
+/* Start batch: classes of several containers are created in one pass */
+TError TNetwork::SetupClasses(const std::vector<TNetClass *> &classes) {
     TError error;
 
     if (this != HostNetwork.get()) {
-        if (&cls == RootClass) {
+        if (std::find(classes.begin(), classes.end(), RootClass) != classes.end()) {
             auto net_lock = LockNet();
             auto net_state_lock = LockNetState();
             for (auto &dev: Devices)
                 if (dev.Uplink)
                     SetupPolice(dev);
         }
-        return HostNetwork->SetupClasses(cls);
+        return HostNetwork->SetupClasses(classes);
     }
 
-    error = TrySetupClasses(cls);
+    error = TrySetupClasses(classes);
     if (error) {
         L_NET_VERBOSE("Network {} class setup failed: {}", NetName, error);
         StartRepair();
         error = WaitRepair();
         if (error)
             return error;
-        error = TrySetupClasses(cls);
+        error = TrySetupClasses(classes);
         if (error) {
             StartRepair();
             return error;
@@ -1396,6 +1592,7 @@ void TNetwork::RegisterClass(TNetClass &cls) {
     else
         NetClasses.insert(++pos, &cls);
     cls.Registered++;
+    StatChanged = true;
 }
 
 void TNetwork::UnregisterClass(TNetClass &cls) {
@@ -1403,21 +1600,53 @@ void TNetwork::UnregisterClass(TNetClass &cls) {
     if (pos == NetClasses.end())
         return;
 
-    if (cls.Parent && (NetclsSubsystem.HasPriority || cls.OriginNet.get() == this)) {
-        for (int cs = 0; cs < NR_TC_CLASSES; cs++)
-            cls.Parent->ClassStat[fmt::format("Saved CS{}", cs)] += cls.ClassStat[fmt::format("CS{}", cs)];
+    if (cls.Parent && ClassStatVisible(cls)) {
+        for (int cs = 0; cs < NR_TC_CLASSES; cs++) {
+            cls.Parent->SavedStat[cs] += cls.SavedStat[cs];
+            for (size_t i = cs; i < cls.DevStat.size(); i += NR_TC_CLASSES)
+                cls.Parent->SavedStat[cs] += cls.DevStat[i];
+        }
     }
 
     NetClasses.erase(pos);
     cls.Registered--;
+    StatChanged = true;
+}
+
+bool TNetwork::ClassStatVisible(const TNetClass &cls) const {
+    return NetclsSubsystem.HasPriority || cls.OriginNet.get() == this;
+}
+
+/* Move statistics of vanished device into saved */
+void TNetwork::SaveDeviceStat(const std::string &name) {
+    for (size_t slot = 0; slot < StatDevices.size(); slot++) {
+        if (StatDevices[slot].Name != name)
+            continue;
+
+        for (auto cls: NetClasses) {
+            if (cls->DevStat.size() < (slot + 1) * NR_TC_CLASSES)
+                continue;
+            for (int cs = 0; cs < NR_TC_CLASSES; cs++) {
+                auto &stat = cls->DevStat[slot * NR_TC_CLASSES + cs];
+                cls->SavedStat[cs] += stat;
+                stat.Reset();
+            }
+        }
+
+        StatDevices[slot].Name = "";
+    }
 }
 
 TError TNetwork::Reconnect() {
     TNamespaceFd netns, cur_ns;
     TError error;
 
-    if (this == HostNetwork.get())
-        return Nl->Connect();
+    if (this == HostNetwork.get()) {
+        error = Nl->Connect();
+        if (!error)
+            (void)ConnectEvents();
+        return error;
+    }
 
     error = cur_ns.Open("/proc/thread-self/ns/net");
     if (error)
@@ -1432,8 +1661,10 @@ TError TNetwork::Reconnect() {
             error = netns.SetNs(CLONE_NEWNET);
         if (!error)
             error = Nl->Connect();
-        if (!error)
+        if (!error) {
+            (void)ConnectEvents();
             break;
+        }
     }
     state_lock.unlock();
 
@@ -1445,7 +1676,11 @@ TError TNetwork::Reconnect() {
 TError TNetwork::RepairLocked() {
     TError error;
 
-    L_NET("Repair network {}", NetName);
+    /* Failed repair or broken classes require full resync */
+    bool all = RepairAll || NetError != EError::Queued;
+    RepairAll = false;
+
+    L_NET("Repair network {}{}", NetName, all ? "" : " devices");
 
     NetError = TError::Queued();
 
@@ -1460,12 +1695,16 @@ TError TNetwork::RepairLocked() {
 
     bool force = false;
     auto state_lock = LockNetState();
+    std::vector<TNetClass *> classes(NetClasses.begin(), NetClasses.end());
 
     if (error)
         goto out;
 
 retry:
     for (auto &dev: Devices) {
+        if (dev.Prepared && !all && !force)
+            continue;
+
         if (dev.Uplink)
             SetupPolice(dev);
 
@@ -1485,15 +1724,7 @@ retry:
             dev.Prepared = true;
         }
 
-        for (auto cls: NetClasses) {
-            for (int cs = 0; cs < NR_TC_CLASSES; cs++) {
-                error = SetupClass(dev, *cls, cs);
-                if (error)
-                    break;
-            }
-            if (error)
-                break;
-        }
+        error = SetupClassesBatch({&dev}, classes);
         if (error)
             break;
     }
@@ -1560,34 +1791,90 @@ TError TNetwork::SyncResolvConf() {
     return OK;
 }
 
-void TNetwork::NetWatchdog() {
+void TNetwork::Watchdog() {
+    auto lock = LockNet();
+    auto now = GetCurrentTimeMs();
+
+    if (EventsPending.exchange(false))
+        HandleEventsLocked();
+
+    /*
+     * With link notifications only host network needs polling:
+     * class statistics must be saved before devices vanish.
+     * Container networks sync statistics on demand unless
+     * they are mocked into host classes. Broken or slow
+     * network backs off periodic sync, events are still handled.
+     */
+    bool sync = now >= WatchdogTime &&
+        (!EventsSource || this == HostNetwork.get() ||
+         !NetclsSubsystem.HasPriority) &&
+        now - StatTime >= NetWatchdogPeriod;
+
+    if (sync) {
+        GlobalStatGen++;
+        SyncStatLocked();
+    }
+
+    /* Repair is never delayed: container starts wait for it */
+    TError error;
+    if (NetError)
+        error = RepairLocked();
+
+    auto elapsed = GetCurrentTimeMs() - now;
+
+    if (elapsed > NetWatchdogDeadline) {
+        Statistics->NetworkWatchdogOverruns++;
+        L_WRN("Network {} watchdog took {} ms", NetName, elapsed);
+        if (!error)
+            error = TError(EError::Unknown, "Deadline exceeded");
+    }
+
+    if (error) {
+        uint64_t delay = NetWatchdogPeriod << std::min(WatchdogFailures.load(), 16u);
+        delay = std::min(delay, NetWatchdogBackoff);
+        WatchdogFailures++;
+        WatchdogTime = GetCurrentTimeMs() + delay;
+        L_NET("Network {} sync backoff {} ms after {} failures: {}",
+              NetName, delay, WatchdogFailures.load(), error);
+    } else if (WatchdogFailures && now >= WatchdogTime) {
+        /* Periodic sync might never run here, any clean pass resets */
+        WatchdogFailures = 0;
+        WatchdogTime = 0;
+    }
+}
+
+/* Each thread handles networks with NetInode % threads == shard */
+void TNetwork::NetWatchdog(unsigned shard) {
     auto LastProxyNeighbour = GetCurrentTimeMs();
     auto LastResolvConf = LastProxyNeighbour;
-    TError error;
+    unsigned shards = NetThreads.size();
+
+    SetProcessName(fmt::format("portod-NET{}", shard));
 
-    SetProcessName("portod-NET");
     while (HostNetwork) {
+        auto networks_lock = LockNetworks();
+        auto gen = NetEventGen;
+        networks_lock.unlock();
+
         auto nets = Networks();
         for (auto &net: *nets) {
-            auto lock = net->LockNet();
-            if (GetCurrentTimeMs() - net->StatTime >= NetWatchdogPeriod) {
-                GlobalStatGen++;
-                net->SyncStatLocked();
-            }
-            if (net->NetError)
-                net->RepairLocked();
+            if (net->NetInode % shards == shard)
+                net->Watchdog();
         }
-        if (GetCurrentTimeMs() - LastProxyNeighbour >= NetProxyNeighbourPeriod) {
+
+        if (!shard && GetCurrentTimeMs() - LastProxyNeighbour >= NetProxyNeighbourPeriod) {
             auto lock = HostNetwork->LockNet();
             HostNetwork->RepairProxyNeightbour();
             LastProxyNeighbour = GetCurrentTimeMs();
         }
-        if (ResolvConfPeriod && GetCurrentTimeMs() - LastResolvConf >= ResolvConfPeriod) {
+        if (!shard && ResolvConfPeriod && GetCurrentTimeMs() - LastResolvConf >= ResolvConfPeriod) {
             TNetwork::SyncResolvConf();
             LastResolvConf = GetCurrentTimeMs();
         }
-        auto lock = LockNetworks();
-        NetThreadCv.wait_for(lock, std::chrono::milliseconds(NetWatchdogPeriod/2));
+
+        networks_lock.lock();
+        if (gen == NetEventGen)
+            NetThreadCv.wait_for(networks_lock, std::chrono::milliseconds(NetWatchdogPeriod/2));
     }
 }
 
@@ -1596,6 +1883,7 @@ void TNetwork::StartRepair() {
         L_NET_VERBOSE("Start network {} repair", NetName);
     if (!NetError)
         NetError = TError::Queued();
+    RepairAll = true;
     NetThreadCv.notify_all();
 }
 
@@ -1614,13 +1902,26 @@ TError TNetwork::WaitRepair() {
 }
 
 void TNetwork::InitStat(TNetClass &cls) {
-    cls.ClassStat.clear();
-    for (auto &dev: Devices) {
-        cls.ClassStat[dev.Name] = dev.DeviceStat;
-        cls.ClassStat["group " + dev.GroupName] += dev.DeviceStat;
-        if (dev.Uplink)
-            cls.ClassStat["Uplink"] += dev.DeviceStat;
+    cls.DevStat.clear();
+    cls.MockStat.clear();
+    for (int cs = 0; cs < NR_TC_CLASSES; cs++) {
+        cls.LeafStat[cs].Reset();
+        cls.FallbackStat[cs].Reset();
+        cls.SavedStat[cs].Reset();
     }
+    for (auto &dev: Devices)
+        cls.MockStat.push_back({dev.Name, dev.GroupName, dev.Uplink, -1, dev.DeviceStat});
+}
+
+/* Dense index for leaf classes 1:<id><cs>, -1 for others */
+static int TcStatIndex(uint32_t handle) {
+    uint32_t minor = TC_H_MIN(handle);
+
+    if (TC_H_MAJ(handle) != TC_H_MAKE(ROOT_TC_MAJOR << 16, 0) ||
+            minor < ROOT_TC_MINOR || (minor & META_TC_MINOR))
+        return -1;
+
+    return (minor >> 4) * NR_TC_CLASSES + (minor & (META_TC_MINOR - 1));
 }
 
 void TNetwork::SyncStatLocked() {
@@ -1628,6 +1929,7 @@ void TNetwork::SyncStatLocked() {
 
     auto curTime = GetCurrentTimeMs();
     auto curGen = GlobalStatGen.load();
+    bool changed = false;
 
     L_NET_VERBOSE("Sync network {} statistics generation {} after {} ms",
           NetName, (unsigned)curGen, curTime - StatTime);
@@ -1639,115 +1941,122 @@ void TNetwork::SyncStatLocked() {
     }
 
     for (auto &dev: Devices) {
-        dev.ClassCache = nullptr;
-
-        if (!dev.Managed || !dev.Prepared)
-            continue;
+        std::vector<TNlTcStat> stat;
+        std::vector<bool> present;
+
+        if (dev.Managed && dev.Prepared && !NetClasses.empty()) {
+            error = Nl->DumpClassStat(dev.Index, [&](uint32_t handle, const TNlTcStat &tc) {
+                int index = TcStatIndex(handle);
+                if (index < 0)
+                    return;
+                if ((size_t)index >= stat.size()) {
+                    stat.resize(index + NR_TC_CLASSES);
+                    present.resize(index + NR_TC_CLASSES);
+                }
+                stat[index] = tc;
+                present[index] = true;
+            });
+            if (error) {
+                L_NET("Cannot dump network {} classes at {}:{} {}", NetName, dev.Index, dev.Name, error);
+                StartRepair();
+                stat.clear();
+                present.clear();
+            }
+        }
 
-        int ret = rtnl_class_alloc_cache(GetSock(), dev.Index, &dev.ClassCache);
-        if (ret) {
-            L_NET("Cannot dump network {} classes at {}:{}", NetName, dev.Index, dev.Name);
-            StartRepair();
-            continue;
+        if (stat != dev.TcStat || present != dev.TcPresent) {
+            dev.TcStat.swap(stat);
+            dev.TcPresent.swap(present);
+            changed = true;
         }
     }
 
     auto state_lock = LockNetState();
 
-    for (auto cls: NetClasses) {
-        for (auto &it: cls->ClassStat) {
-            if (!StringStartsWith(it.first, "Saved "))
-                it.second.Reset();
-        }
-        for (int cs = 0; cs < NR_TC_CLASSES; cs++)
-            cls->ClassStat[fmt::format("CS{}", cs)] += cls->ClassStat[fmt::format("Saved CS{}", cs)];
-    }
-
-    for (auto &dev: Devices) {
+    if (changed || StatChanged) {
+        StatChanged = false;
 
-        if (!dev.ClassCache)
-            continue;
+        StatDevices.clear();
+        for (auto &dev: Devices) {
+            if (!dev.TcStat.empty())
+                StatDevices.push_back({dev.Name, dev.GroupName, dev.Uplink, dev.Owner});
+        }
 
         for (auto cls: NetClasses) {
+            cls->DevStat.assign(StatDevices.size() * NR_TC_CLASSES, TNetStat());
+            for (int cs = 0; cs < NR_TC_CLASSES; cs++) {
+                cls->LeafStat[cs].Reset();
+                cls->FallbackStat[cs].Reset();
+            }
+        }
 
-            if (dev.Owner && dev.Owner != cls->Owner)
+        size_t slot = 0;
+        for (auto &dev: Devices) {
+            if (dev.TcStat.empty())
                 continue;
 
-            if (!NetclsSubsystem.HasPriority && cls->OriginNet.get() != this)
-                continue;
+            for (auto cls: NetClasses) {
 
-            for (int cs = 0; cs < NR_TC_CLASSES; cs++) {
-                struct rtnl_class *tc = rtnl_class_get(dev.ClassCache, dev.Index, cls->LeafHandle + cs);
-                if (!tc) {
-                    L_NET("Missing network {} class {:#x} at {}:{}", NetName, cls->LeafHandle + cs, dev.Index, dev.Name);
-                    StartRepair();
+                if (dev.Owner && dev.Owner != cls->Owner)
                     continue;
-                }
-                auto cs_name = fmt::format("{} CS{}", dev.Name, cs);
-                TNetStat &stat = cls->ClassStat[cs_name];
-                stat.TxPackets += rtnl_tc_get_stat(TC_CAST(tc), RTNL_TC_PACKETS);
-                stat.TxBytes += rtnl_tc_get_stat(TC_CAST(tc), RTNL_TC_BYTES);
-                stat.TxDrops += rtnl_tc_get_stat(TC_CAST(tc), RTNL_TC_DROPS);
-                stat.TxOverruns += rtnl_tc_get_stat(TC_CAST(tc), RTNL_TC_OVERLIMITS);
-                rtnl_class_put(tc);
-
-                cls->ClassStat[fmt::format("Leaf CS{}", cs)] += stat;
-
-                if (cls->LeafHandle == TC_HANDLE(ROOT_TC_MAJOR, ROOT_TC_MINOR)) {
-                    struct rtnl_class *tc = rtnl_class_get(dev.ClassCache, dev.Index, TC_HANDLE(ROOT_TC_MAJOR, DEFAULT_TC_MINOR) + cs);
-                    if (!tc) {
-                        L_NET("Missing network {} class {:#x} at {}:{}", NetName, TC_HANDLE(ROOT_TC_MAJOR, DEFAULT_TC_MINOR) + cs, dev.Index, dev.Name);
+
+                if (!ClassStatVisible(*cls))
+                    continue;
+
+                for (int cs = 0; cs < NR_TC_CLASSES; cs++) {
+                    int index = TcStatIndex(cls->LeafHandle + cs);
+                    if (index < 0 || (size_t)index >= dev.TcStat.size() || !dev.TcPresent[index]) {
+                        L_NET("Missing network {} class {:#x} at {}:{}", NetName, cls->LeafHandle + cs, dev.Index, dev.Name);
                         StartRepair();
                         continue;
                     }
-                    TNetStat &def_stat = cls->ClassStat[fmt::format("Fallback CS{}", cs)];
-                    def_stat.TxPackets += rtnl_tc_get_stat(TC_CAST(tc), RTNL_TC_PACKETS);
-                    def_stat.TxBytes += rtnl_tc_get_stat(TC_CAST(tc), RTNL_TC_BYTES);
-                    def_stat.TxDrops += rtnl_tc_get_stat(TC_CAST(tc), RTNL_TC_DROPS);
-                    def_stat.TxOverruns += rtnl_tc_get_stat(TC_CAST(tc), RTNL_TC_OVERLIMITS);
-                    rtnl_class_put(tc);
-                    stat += def_stat;
+
+                    TNetStat &stat = cls->DevStat[slot * NR_TC_CLASSES + cs];
+                    stat += dev.TcStat[index];
+                    cls->LeafStat[cs] += dev.TcStat[index];
+
+                    if (cls->LeafHandle == TC_HANDLE(ROOT_TC_MAJOR, ROOT_TC_MINOR)) {
+                        int index = TcStatIndex(TC_HANDLE(ROOT_TC_MAJOR, DEFAULT_TC_MINOR) + cs);
+                        if ((size_t)index >= dev.TcStat.size() || !dev.TcPresent[index]) {
+                            L_NET("Missing network {} class {:#x} at {}:{}", NetName, TC_HANDLE(ROOT_TC_MAJOR, DEFAULT_TC_MINOR) + cs, dev.Index, dev.Name);
+                            StartRepair();
+                            continue;
+                        }
+                        cls->FallbackStat[cs] += dev.TcStat[index];
+                        stat += dev.TcStat[index];
+                    }
                 }
             }
-        }
 
-        for (auto it = NetClasses.rbegin(); it != NetClasses.rend(); ++it) {
-            auto cls = *it;
-
-            if (dev.Owner && dev.Owner != cls->Owner)
-                continue;
+            /* Childs before parents */
+            if (dev.Managed && !dev.Owner) {
+                for (auto it = NetClasses.rbegin(); it != NetClasses.rend(); ++it) {
+                    auto cls = *it;
 
-            if (!NetclsSubsystem.HasPriority && cls->OriginNet.get() != this)
-                continue;
-
-            for (int cs = 0; cs < NR_TC_CLASSES; cs++) {
-                auto cs_name = fmt::format("{} CS{}", dev.Name, cs);
+                    if (!cls->Parent || !ClassStatVisible(*cls))
+                        continue;
 
-                TNetStat &stat = cls->ClassStat[cs_name];
-                cls->ClassStat[fmt::format("CS{}", cs)] += stat;
-                cls->ClassStat[dev.Name] += stat;
-                cls->ClassStat["group " + dev.GroupName] += stat;
-                if (dev.Uplink)
-                    cls->ClassStat["Uplink"] += stat;
-                if (cls->Parent && dev.Managed && !dev.Owner)
-                    cls->Parent->ClassStat[cs_name] += stat;
+                    for (int cs = 0; cs < NR_TC_CLASSES; cs++)
+                        cls->Parent->DevStat[slot * NR_TC_CLASSES + cs] +=
+                            cls->DevStat[slot * NR_TC_CLASSES + cs];
+                }
             }
+
+            slot++;
         }
     }
 
+    for (auto cls: NetClasses)
+        cls->MockStat.clear();
+
     /* Mock statistics if traffic goes into fallback tc class in host. */
     if (!NetclsSubsystem.HasPriority) {
         for (auto cls: NetClasses) {
             if (cls->OriginNet.get() != this) {
                 for (auto &dev: cls->OriginNet->Devices) {
-                    auto &stat = cls->OriginNet->DeviceStat[dev.Name];
-                    for (auto c = cls; c && c->Owner != ROOT_CONTAINER_ID; c = c->Parent) {
-                        c->ClassStat[FormatTos(cls->DefaultTos)] += stat;
-                        c->ClassStat[dev.Name] += stat;
-                        c->ClassStat["group " + dev.GroupName] += stat;
-                        if (dev.Uplink)
-                            c->ClassStat["Uplink"] += stat;
-                    }
+                    for (auto c = cls; c && c->Owner != ROOT_CONTAINER_ID; c = c->Parent)
+                        c->MockStat.push_back({dev.Name, dev.GroupName, dev.Uplink,
+                                               cls->DefaultTos, dev.DeviceStat});
                 }
             }
         }
@@ -1758,10 +2067,65 @@ void TNetwork::SyncStatLocked() {
 
     state_lock.unlock();
 
-    for (auto &dev: Devices) {
-        if (dev.ClassCache)
-            nl_cache_free(dev.ClassCache);
-        dev.ClassCache = nullptr;
+    SyncLatency = GetCurrentTimeMs() - curTime;
+    if (SyncLatency > Statistics->NetworkSyncLongest)
+        Statistics->NetworkSyncLongest = SyncLatency.load();
+}
+
+void TNetwork::DumpClassStat(const TNetClass &cls, std::map<std::string, TNetStat> &stat) {
+    PORTO_LOCKED(NetStateMutex);
+
+    auto net = HostNetwork;
+    TNetStat total[NR_TC_CLASSES];
+
+    if (net && cls.Registered && net->ClassStatVisible(cls)) {
+        auto &devices = net->StatDevices;
+
+        for (size_t slot = 0; slot < devices.size() &&
+                (slot + 1) * NR_TC_CLASSES <= cls.DevStat.size(); slot++) {
+            auto &dev = devices[slot];
+            TNetStat sum;
+
+            if (dev.Name.empty() || (dev.Owner && dev.Owner != cls.Owner))
+                continue;
+
+            for (int cs = 0; cs < NR_TC_CLASSES; cs++) {
+                auto &cs_stat = cls.DevStat[slot * NR_TC_CLASSES + cs];
+                stat[fmt::format("{} CS{}", dev.Name, cs)] = cs_stat;
+                total[cs] += cs_stat;
+                sum += cs_stat;
+            }
+
+            stat[dev.Name] += sum;
+            stat["group " + dev.Group] += sum;
+            if (dev.Uplink)
+                stat["Uplink"] += sum;
+        }
+
+        if (!devices.empty()) {
+            for (int cs = 0; cs < NR_TC_CLASSES; cs++)
+                stat[fmt::format("Leaf CS{}", cs)] = cls.LeafStat[cs];
+        }
+
+        if (cls.LeafHandle == TC_HANDLE(ROOT_TC_MAJOR, ROOT_TC_MINOR)) {
+            for (int cs = 0; cs < NR_TC_CLASSES; cs++)
+                stat[fmt::format("Fallback CS{}", cs)] = cls.FallbackStat[cs];
+        }
+    }
+
+    for (int cs = 0; cs < NR_TC_CLASSES; cs++) {
+        total[cs] += cls.SavedStat[cs];
+        stat[fmt::format("CS{}", cs)] = total[cs];
+        stat[fmt::format("Saved CS{}", cs)] = cls.SavedStat[cs];
+    }
+
+    for (auto &mock: cls.MockStat) {
+        if (mock.Tos >= 0)
+            stat[FormatTos(mock.Tos)] += mock.Stat;
+        stat[mock.Device] += mock.Stat;
+        stat["group " + mock.Group] += mock.Stat;
+        if (mock.Uplink)
+            stat["Uplink"] += mock.Stat;
     }
 }
 
@@ -1776,6 +2140,9 @@ void TNetwork::SyncAllStat() {
     auto nets = Networks();
     auto ourGen = GlobalStatGen.fetch_add(1) + 1;
     for (auto &net: *nets) {
+        /* Do not wait for backed off networks, show last statistics */
+        if (net->WatchdogFailures && GetCurrentTimeMs() < net->WatchdogTime)
+            continue;
         if (ourGen - net->StatGen > 0) {
             auto lock = net->LockNet();
             if (ourGen - net->StatGen > 0)
@@ -1918,7 +2285,9 @@ void TNetwork::StopNetwork(TContainer &ct) {
         HostNetwork = nullptr;
         lock.unlock();
         NetThreadCv.notify_all();
-        NetThread.join();
+        for (auto &thread: NetThreads)
+            thread.join();
+        NetThreads.clear();
     }
 
     for (auto &dev : env.Devices) {
@@ -2848,7 +3217,10 @@ TError TNetEnv::OpenNetwork() {
         if (config().network().has_nat_count())
             Net->NatBitmap.Resize(config().network().nat_count());
 
-        NetThread = std::thread(&TNetwork::NetWatchdog);
+        unsigned threads = std::max(config().network().watchdog_threads(), 1u);
+        NetThreads.resize(threads);
+        for (unsigned shard = 0; shard < threads; shard++)
+            NetThreads[shard] = std::thread(&TNetwork::NetWatchdog, shard);
 
         return OK;
     }
@@ -16,6 +16,7 @@
 
 class TContainer;
 class TNetwork;
+class TEpollSource;
 struct TTaskEnv;
 
 struct TNetStat {
@@ -40,6 +41,13 @@ struct TNetStat {
         RxOverruns += a.RxOverruns;
     }
 
+    void operator+=(const TNlTcStat &a) {
+        TxBytes += a.Bytes;
+        TxPackets += a.Packets;
+        TxDrops += a.Drops;
+        TxOverruns += a.Overlimits;
+    }
+
     void Reset() {
         TxBytes = 0;
         TxPackets = 0;
@@ -65,7 +73,22 @@ struct TNetClass {
     TUintMap TxLimit;
     TUintMap RxLimit;
 
-    std::map<std::string, TNetStat> ClassStat;
+    /* Per host device and CS, layout is TNetwork::StatDevices */
+    std::vector<TNetStat> DevStat;
+    TNetStat LeafStat[NR_TC_CLASSES];
+    TNetStat FallbackStat[NR_TC_CLASSES];
+    TNetStat SavedStat[NR_TC_CLASSES];
+
+    /* Device statistics of origin network if traffic isn't classified */
+    struct TMockStat {
+        std::string Device;
+        std::string Group;
+        bool Uplink;
+        int Tos;    /* -1 - initial */
+        TNetStat Stat;
+    };
+    std::vector<TMockStat> MockStat;
+
     std::shared_ptr<TNetwork> OriginNet;
 
     TNetClass *Fold;
@@ -91,7 +114,9 @@ public:
 
     TNetStat DeviceStat;
 
-    struct nl_cache *ClassCache = nullptr;
+    /* Raw tc class counters indexed by TcStatIndex(handle) */
+    std::vector<TNlTcStat> TcStat;
+    std::vector<bool> TcPresent;
 
     TNetDevice(struct rtnl_link *);
 
@@ -136,9 +161,21 @@ class TNetwork : public TNonCopyable {
 
     TNetClass *RootClass = nullptr;
 
+    /* Host devices with tc classes, protected with NetStateMutex */
+    struct TStatDevice {
+        std::string Name;
+        std::string Group;
+        bool Uplink;
+        int Owner;
+    };
+    std::vector<TStatDevice> StatDevices;
+    bool StatChanged = true;
+
     void InitStat(TNetClass &cls);
     void RegisterClass(TNetClass &cls);
     void UnregisterClass(TNetClass &cls);
+    bool ClassStatVisible(const TNetClass &cls) const;
+    void SaveDeviceStat(const std::string &name);
 
     std::list<TContainer *> NetUsers;
 
@@ -154,7 +191,9 @@ class TNetwork : public TNonCopyable {
     std::atomic<int> StatGen;
     std::atomic<uint64_t> StatTime;
 
-    TError TrySetupClasses(TNetClass &cls);
+    TError TrySetupClasses(const std::vector<TNetClass *> &classes);
+    TError SetupClassesBatch(const std::vector<TNetDevice *> &devices,
+                             const std::vector<TNetClass *> &classes);
 
     void SyncStatLocked();
     TError Reconnect();
@@ -163,6 +202,28 @@ class TNetwork : public TNonCopyable {
     /* Something went wrong, handled by Repair */
     TError NetError;
 
+    /* Repair all devices and classes, otherwise only unprepared devices */
+    bool RepairAll = false;
+
+    /* Link notifications, see NetlinkEvent */
+    std::shared_ptr<TNl> NlEvents;
+    std::shared_ptr<TEpollSource> EventsSource;
+    std::atomic<int> EventsFd{-1};
+    std::atomic<bool> EventsPending{false};
+
+    /* Backoff for networks which fail repair or exceed deadline */
+    std::atomic<uint64_t> WatchdogTime{0};
+    std::atomic<unsigned> WatchdogFailures{0};
+
+    void Watchdog();
+
+    TError ConnectEvents();
+    void DisconnectEvents();
+    void HandleEventsLocked();
+
+    void SyncDevice(struct rtnl_link *link);
+    void ForgetDevices();
+
 public:
     TNetwork();
     ~TNetwork();
@@ -210,13 +271,15 @@ public:
 
     static void InitClass(TContainer &ct);
 
-    TError SetupClass(TNetDevice &dev, TNetClass &cls, int cs);
+    TError SetupClass(TNetDevice &dev, TNetClass &cls, int cs, TNlBatch *batch = nullptr);
     TError DeleteClass(TNetDevice &dev, TNetClass &cls, int cs);
     TError SetupClasses(TNetClass &cls);
+    TError SetupClasses(const std::vector<TNetClass *> &classes);
     TError SetupPolice(TNetDevice &dev);
 
     void SyncStat();
     static void SyncAllStat();
+    static void DumpClassStat(const TNetClass &cls, std::map<std::string, TNetStat> &stat);
 
     TError GetGateAddress(std::vector<TNlAddr> addrs,
                           TNlAddr &gate4, TNlAddr &gate6, int &mtu, int &group);
@@ -252,7 +315,11 @@ public:
     static void StopNetwork(TContainer &ct);
     static TError RestoreNetwork(TContainer &ct);
 
-    static void NetWatchdog();
+    /* Duration of last statistics sync in ms */
+    std::atomic<uint64_t> SyncLatency{0};
+
+    static void NetWatchdog(unsigned shard);
+    static void NetlinkEvent(int fd);
 
     static TError SyncResolvConf();
 };
@@ -22,6 +22,7 @@ extern "C" {
 #include <wordexp.h>
 #include <termios.h>
 #include <poll.h>
+#include <sys/inotify.h>
 }
 
 using std::string;
@@ -766,10 +767,31 @@ public:
 
 class TStartCmd final : public ICmd {
 public:
-    TStartCmd(Porto::Connection *api) : ICmd(api, "start", 1, "<container1> [container2...]", "start container") {}
+    TStartCmd(Porto::Connection *api) : ICmd(api, "start", 1, "[-p] [-r] <container1> [container2...]",
+            "start container",
+            "    -p        start containers in parallel, parents first\n"
+            "    -r        also start stopped descendants, implies -p\n"
+            ) {}
 
     int Execute(TCommandEnviroment *env) final override {
-        for (const auto &arg : env->GetArgs()) {
+        bool batch = false, subtree = false;
+
+        const auto &containers = env->GetOpts({
+            { 'p', false, [&](const char *) { batch = true; } },
+            { 'r', false, [&](const char *) { batch = subtree = true; } },
+        });
+
+        if (batch) {
+            std::map<std::string, Porto::BatchResult> result;
+            int ret = Api->StartBatch(containers, result, subtree);
+            if (ret) {
+                PrintError("Can't start containers");
+                return ret;
+            }
+            return PrintErrors(result, "Can't start container");
+        }
+
+        for (const auto &arg : containers) {
             int ret = Api->Start(arg);
             if (ret) {
                 PrintError("Can't start container");
@@ -862,16 +884,29 @@ public:
 
 class TStopCmd final : public ICmd {
 public:
-    TStopCmd(Porto::Connection *api) : ICmd(api, "stop", 1, "[-T <seconds>] <container1> [container2...]", "stop container",
-             "    -T <seconds> per-container stop timeout\n") {}
+    TStopCmd(Porto::Connection *api) : ICmd(api, "stop", 1, "[-p] [-T <seconds>] <container1> [container2...]", "stop container",
+             "    -T <seconds> per-container stop timeout\n"
+             "    -p           stop containers in parallel\n") {}
 
     int Execute(TCommandEnviroment *env) final override {
         int timeout = -1;
+        bool batch = false;
 
         const auto &containers = env->GetOpts({
             { 'T', true, [&](const char *arg) { timeout = std::stoi(arg); } },
+            { 'p', false, [&](const char *) { batch = true; } },
         });
 
+        if (batch) {
+            std::map<std::string, Porto::BatchResult> result;
+            int ret = Api->StopBatch(containers, result, timeout);
+            if (ret) {
+                PrintError("Can't stop containers");
+                return ret;
+            }
+            return PrintErrors(result, "Can't stop container");
+        }
+
         for (const auto &arg : containers) {
             int ret = Api->Stop(arg, timeout);
             if (ret) {
@@ -1293,6 +1328,7 @@ public:
             return ret;
         }
 
+        vector<string> dead;
         for (const auto &c : clist) {
             if (c == "/")
                 continue;
@@ -1304,17 +1340,21 @@ public:
                 continue;
             }
 
-            if (state != "dead")
-                continue;
+            if (state == "dead")
+                dead.push_back(c);
+        }
 
-            int ret = Api->Destroy(c);
-            if (ret) {
-                PrintError("Can't destroy container");
-                return ret;
-            }
+        if (dead.empty())
+            return EXIT_SUCCESS;
+
+        std::map<std::string, Porto::BatchResult> result;
+        ret = Api->DestroyBatch(dead, result);
+        if (ret) {
+            PrintError("Can't destroy containers");
+            return ret;
         }
 
-        return EXIT_SUCCESS;
+        return PrintErrors(result, "Can't destroy container");
     }
 };
 
@@ -1354,11 +1394,28 @@ public:
 
 class TDestroyCmd final : public ICmd {
 public:
-    TDestroyCmd(Porto::Connection *api) : ICmd(api, "destroy", 1, "<container1> [container2...]", "destroy container") {}
+    TDestroyCmd(Porto::Connection *api) : ICmd(api, "destroy", 1, "[-p] <container1> [container2...]", "destroy container",
+             "    -p           destroy containers in parallel\n") {}
 
     int Execute(TCommandEnviroment *env) final override {
         int exitStatus = EXIT_SUCCESS;
-        for (const auto &arg : env->GetArgs()) {
+        bool batch = false;
+
+        const auto &containers = env->GetOpts({
+            { 'p', false, [&](const char *) { batch = true; } },
+        });
+
+        if (batch) {
+            std::map<std::string, Porto::BatchResult> result;
+            int ret = Api->DestroyBatch(containers, result);
+            if (ret) {
+                PrintError("Can't destroy containers");
+                return ret;
+            }
+            return PrintErrors(result, "Can't destroy container");
+        }
+
+        for (const auto &arg : containers) {
             int ret = Api->Destroy(arg);
             if (ret) {
                 PrintError("Can't destroy container");
@@ -2247,7 +2304,7 @@ public:
             }
         } else if (list) {
             std::vector<Porto::Layer> layers;
-            ret = Api->ListLayers(layers, place);
+            ret = Api->ListLayers(layers, place, "", verbose);
             if (ret) {
                 PrintError("Can't list layers");
             } else {
@@ -2261,6 +2318,9 @@ public:
                         std::cout << "\tused\t" << StringFormatDuration(l.LastUsage * 1000) << " ago" << std::endl;
                     if (l.PrivateValue.size())
                         std::cout << "\tprivate\t" << l.PrivateValue << std::endl;
+                    if (l.SpaceUsed || l.SpaceShared)
+                        std::cout << "\tspace\t" << StringFormatSize(l.SpaceUsed) << " own, "
+                                  << StringFormatSize(l.SpaceShared) << " shared" << std::endl;
                     std::cout << std::endl;
                 }
             }
@@ -2748,6 +2808,200 @@ public:
     }
 };
 
+class TLogCmd final : public ICmd {
+public:
+    TLogCmd(Porto::Connection *api) : ICmd(api, "log", 0,
+            "[-f file] [-c container] [-r request] [-l level] [-S seconds] [-i]",
+            "print binary portod log",
+            "    -f <file>       binary log file (default /var/log/portod.binlog)\n"
+            "    -c <container>  records for container name or id\n"
+            "    -r <request>    records for request id\n"
+            "    -l <level>      records with level: ACT, REQ, RSP, WRN, ERR, ...\n"
+            "    -S <seconds>    records for last seconds\n"
+            "    -i              print container and request ids\n") {}
+
+    int Execute(TCommandEnviroment *env) final override {
+        TBinaryLogReader reader;
+        TBinaryLogEntry entry;
+        std::string path = PORTO_BINARY_LOG, container;
+        bool ids = false, recent = false, eof;
+        uint64_t since = 0;
+        TError error;
+
+        env->GetOpts({
+            { 'f', true, [&](const char *arg) { path = arg; } },
+            { 'c', true, [&](const char *arg) { container = arg; } },
+            { 'r', true, [&](const char *arg) {
+                if (!error)
+                    error = StringToUint64(arg, reader.RequestId); } },
+            { 'l', true, [&](const char *arg) { reader.Level = arg; } },
+            { 'S', true, [&](const char *arg) {
+                recent = true;
+                if (!error)
+                    error = StringToUint64(arg, since); } },
+            { 'i', false, [&](const char *) { ids = true; } },
+        });
+
+        if (error) {
+            PrintError(error, "Invalid option");
+            PrintUsage();
+            return EXIT_FAILURE;
+        }
+
+        if (recent) {
+            uint64_t now = time(nullptr);
+            reader.Since = (now - std::min(now, since)) * 1000000;
+        }
+
+        if (container.size() && StringToUint64(container, reader.ContainerId)) {
+            std::string id;
+            int ret = Api->GetProperty(container, "id", id);
+            if (ret) {
+                PrintError("Cannot get container id");
+                return ret;
+            }
+            error = StringToUint64(id, reader.ContainerId);
+            if (error) {
+                PrintError(error, "Cannot parse container id");
+                return EXIT_FAILURE;
+            }
+        }
+
+        error = reader.Open(path);
+        if (error) {
+            PrintError(error, "Cannot open log");
+            return EXIT_FAILURE;
+        }
+
+        while (true) {
+            error = reader.Next(entry, eof);
+            if (error) {
+                PrintError(error, "Cannot read log");
+                return EXIT_FAILURE;
+            }
+            if (eof)
+                break;
+            if (ids)
+                fmt::print("{} {}[{}]: {} CT{} REQ{} {}\n", FormatTime(entry.Time / 1000000),
+                           entry.Task, entry.Tid, entry.Level, entry.ContainerId,
+                           entry.RequestId, entry.Text);
+            else
+                fmt::print("{} {}[{}]: {} {}\n", FormatTime(entry.Time / 1000000),
+                           entry.Task, entry.Tid, entry.Level, entry.Text);
+        }
+        fflush(stdout);
+
+        return EXIT_SUCCESS;
+    }
+};
+
+class TFollowCmd final : public ICmd {
+public:
+    TFollowCmd(Porto::Connection *api) : ICmd(api, "follow", 1,
+            "[-e] [-n bytes] <container>",
+            "print stdout or stderr until container stops",
+            "    -e          follow stderr instead of stdout\n"
+            "    -n <bytes>  start from last bytes, default whole stored stream\n") {}
+
+    int Execute(TCommandEnviroment *env) final override {
+        std::string stream = "stdout";
+        uint64_t tail = 0, offset, pos;
+        bool last = false;
+        struct stat st;
+        char buf[65536];
+        TFile file, notify;
+        TError error;
+        int fd, ret;
+
+        const auto &args = env->GetOpts({
+            { 'e', false, [&](const char *) { stream = "stderr"; } },
+            { 'n', true, [&](const char *arg) {
+                if (!error)
+                    error = StringToUint64(arg, tail); } },
+        });
+
+        if (error) {
+            PrintError(error, "Invalid option");
+            PrintUsage();
+            return EXIT_FAILURE;
+        }
+
+        auto name = args[0];
+
+        ret = Api->OpenStream(name, stream, fd, offset);
+        if (ret) {
+            PrintError("Cannot open " + stream);
+            return ret;
+        }
+        file.SetFd = fd;
+
+        if (fstat(file.Fd, &st)) {
+            PrintError(TError::System("fstat"), "Cannot follow");
+            return EXIT_FAILURE;
+        }
+        pos = (tail && (uint64_t)st.st_size > tail) ? st.st_size - tail : 0;
+
+        /* Wakeup on writes, fallback to periodic polling */
+        notify.SetFd = inotify_init1(IN_CLOEXEC);
+        if (notify && inotify_add_watch(notify.Fd, fmt::format("/proc/self/fd/{}",
+                                        file.Fd).c_str(), IN_MODIFY) < 0)
+            notify.Close();
+
+        while (true) {
+            ssize_t len = pread(file.Fd, buf, sizeof(buf), pos);
+
+            if (len < 0) {
+                PrintError(TError::System("read"), "Cannot follow");
+                return EXIT_FAILURE;
+            }
+
+            if (len > 0) {
+                for (ssize_t done = 0, n; done < len; done += n) {
+                    n = write(STDOUT_FILENO, buf + done, len - done);
+                    if (n <= 0)
+                        return EXIT_FAILURE;
+                }
+                pos += len;
+                continue;
+            }
+
+            /* Rotation collapses head of file and moves stream offset */
+            if (!fstat(file.Fd, &st) && (uint64_t)st.st_size < pos) {
+                std::string value;
+                uint64_t current;
+
+                if (!Api->GetProperty(name, stream + "_offset", value) &&
+                        !StringToUint64(value, current) && current > offset) {
+                    pos -= std::min(pos, current - offset);
+                    offset = current;
+                } else
+                    pos = st.st_size;
+                continue;
+            }
+
+            if (last)
+                break;
+
+            struct pollfd pfd;
+            pfd.fd = notify.Fd;
+            pfd.events = POLLIN;
+            pfd.revents = 0;
+            if (poll(&pfd, 1, notify ? 5000 : 1000) > 0) {
+                len = read(notify.Fd, buf, sizeof(buf));
+                continue;
+            }
+
+            /* Read the rest after container stop */
+            std::string state;
+            if (Api->GetProperty(name, "state", state) ||
+                    (state != "running" && state != "meta" && state != "starting"))
+                last = true;
+        }
+
+        return EXIT_SUCCESS;
+    }
+};
+
 int main(int argc, char *argv[]) {
     Porto::Connection api;
     TCommandHandler handler(api);
@@ -2787,6 +3041,8 @@ int main(int argc, char *argv[]) {
 
     handler.RegisterCommand<TConvertPathCmd>();
     handler.RegisterCommand<TAttachCmd>();
+    handler.RegisterCommand<TLogCmd>();
+    handler.RegisterCommand<TFollowCmd>();
 
     int ret = handler.HandleCommand(argc, argv);
     if (ret < 0) {
@@ -1,6 +1,8 @@
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <set>
+#include <mutex>
 #include <csignal>
 #include <iostream>
 
@@ -169,10 +171,19 @@ static TError CreatePortoSocket() {
     return OK;
 }
 
+/* Pids reported by master and not yet acknowledged */
+static std::mutex ReportedMutex;
+static std::set<int> ReportedPids;
+
 void AckExitStatus(int pid) {
     if (!pid)
         return;
 
+    if (pid > 0) {
+        std::lock_guard<std::mutex> guard(ReportedMutex);
+        ReportedPids.erase(pid);
+    }
+
     L_DBG("Acknowledge exit status for {}", pid);
     int ret = write(REAP_ACK_FD, &pid, sizeof(pid));
     if (ret != sizeof(pid)) {
@@ -181,6 +192,19 @@ void AckExitStatus(int pid) {
     }
 }
 
+/* Exit status is received via pidfd, master could reap without report */
+void ReapExitStatus(int pid) {
+    std::unique_lock<std::mutex> lock(ReportedMutex);
+    if (ReportedPids.count(pid)) {
+        /* Queued report will ack it, pid might be reused after that */
+        L_DBG("Exit status for {} already reported", pid);
+        return;
+    }
+    lock.unlock();
+
+    AckExitStatus(-pid);
+}
+
 static int RecvExitEvents(int fd) {
     struct pollfd fds[1];
     int nr = 1000;
@@ -211,6 +235,10 @@ retry:
             return 0;
         }
 
+        std::unique_lock<std::mutex> lock(ReportedMutex);
+        ReportedPids.insert(pid);
+        lock.unlock();
+
         TEvent e(EEventType::Exit);
         e.Exit.Pid = pid;
         e.Exit.Status = status;
@@ -356,8 +384,11 @@ static void PortodServer() {
 
     StartRpcQueue();
     EventQueue->Start();
+    TStorage::StartReclaimer();
+    TVolume::StartPool();
 
     if (config().daemon().log_rotate_ms()) {
+        TContainer::StartRotateNotify();
         TEvent ev(EEventType::RotateLogs);
         EventQueue->Add(config().daemon().log_rotate_ms(), ev);
     }
@@ -405,6 +436,8 @@ static void PortodServer() {
                         break;
                     case SIGUSR1:
                         OpenLog(PORTO_LOG);
+                        if (config().log().binary())
+                            OpenBinaryLog(PORTO_BINARY_LOG);
                         break;
                     case SIGUSR2:
                         DumpMallocInfo();
@@ -443,6 +476,18 @@ static void PortodServer() {
                     EventQueue->Add(0, e);
                 }
 
+            } else if (source->Flags & EPOLL_EVENT_EXIT) {
+                auto container = source->Container.lock();
+
+                EpollLoop->StopInput(source->Fd);
+                if (container) {
+                    TEvent e(EEventType::TaskExit, container);
+                    EventQueue->Add(0, e);
+                }
+            } else if (source->Flags & EPOLL_EVENT_NET) {
+                TNetwork::NetlinkEvent(source->Fd);
+            } else if (source->Flags & EPOLL_EVENT_ROTATE) {
+                TContainer::RotateNotifyEvent(source->Fd);
             } else if (Clients.find(source->Fd) != Clients.end()) {
                 auto client = Clients[source->Fd];
                 error = client->Event(ev.events);
@@ -477,6 +522,8 @@ exit:
     L_SYS("Stop threads...");
     EventQueue->Stop();
     StopRpcQueue();
+    TVolume::StopPool();
+    TStorage::StopReclaimer();
 }
 
 static TError TuneLimits() {
@@ -724,6 +771,10 @@ static int Portod() {
         FatalError("Cannot save pid", error);
 
     ReadConfigs();
+
+    if (config().log().binary())
+        OpenBinaryLog(PORTO_BINARY_LOG);
+    StartLogWriter();
     InitPortoGroups();
     InitCapabilities();
     InitIpcSysctl();
@@ -799,6 +850,11 @@ static int Portod() {
             L_SYS("Cannot mount tracefs: {}", error);
     }
 
+    /* Before anything big allocated */
+    error = StartHelperSpawner();
+    if (error)
+        L_WRN("Cannot start helper spawner: {}", error);
+
     EpollLoop = std::unique_ptr<TEpollLoop>(new TEpollLoop());
     EventQueue = std::unique_ptr<TEventQueue>(new TEventQueue());
 
@@ -950,10 +1006,16 @@ static int ReapZombies(int fd) {
     int nr = 0;
 
     while (read(fd, &pid, sizeof(pid)) == sizeof(pid)) {
-        if (pid <= 0)
+        if (pid < 0) {
+            /* Status already consumed, reported zombie will be acked */
+            pid = -pid;
+            if (!Zombies.count(pid)) {
+                L_VERBOSE("Reap unreported zombie pid={}", pid);
+                (void)waitpid(pid, NULL, WNOHANG);
+            }
+        } else if (!pid) {
             continue;
-
-        if (Zombies.find(pid) == Zombies.end()) {
+        } else if (Zombies.find(pid) == Zombies.end()) {
             L_WRN("Got ack for unknown zombie pid={}", pid);
         } else {
             L_VERBOSE("Reap zombie pid={}", pid);
@@ -1041,7 +1103,9 @@ static void SpawnPortod(std::shared_ptr<TEpollLoop> loop) {
         close(ackfd[1]);
         close(sigFd);
 
-        _exit(Portod());
+        int ret = Portod();
+        StopLogWriter();
+        _exit(ret);
     }
 
     close(evtfd[0]);
@@ -3081,7 +3081,9 @@ public:
         TUintMap stat;
         auto lock = TNetwork::LockNetState();
         if (ClassStat) {
-            for (auto &it : CT->NetClass.Fold->ClassStat)
+            std::map<std::string, TNetStat> class_stat;
+            TNetwork::DumpClassStat(*CT->NetClass.Fold, class_stat);
+            for (auto &it : class_stat)
                 stat[it.first] = &it.second->*Member;
         } else if (CT->Net) {
             for (auto &it: CT->Net->DeviceStat)
@@ -3093,8 +3095,10 @@ public:
     TError GetIndexed(const std::string &index, std::string &value) {
         auto lock = TNetwork::LockNetState();
         if (ClassStat) {
-            auto it = CT->NetClass.Fold->ClassStat.find(index);
-            if (it == CT->NetClass.Fold->ClassStat.end())
+            std::map<std::string, TNetStat> class_stat;
+            TNetwork::DumpClassStat(*CT->NetClass.Fold, class_stat);
+            auto it = class_stat.find(index);
+            if (it == class_stat.end())
                 return TError(EError::InvalidValue, "network device " + index + " not found");
             value = std::to_string(it->second.*Member);
         } else if (CT->Net) {
@@ -3304,6 +3308,7 @@ void TPortoStat::Populate(TUintMap &m) {
     m["master_uptime"] = (GetCurrentTimeMs() - Statistics->MasterStarted) / 1000;
     m["porto_uptime"] = (GetCurrentTimeMs() - Statistics->PortoStarted) / 1000;
     m["queued_statuses"] = Statistics->QueuedStatuses;
+    m["pidfd_exits"] = Statistics->PidfdExits;
     m["queued_events"] = Statistics->QueuedEvents;
     m["remove_dead"] = Statistics->RemoveDead;
     m["restore_failed"] = Statistics->ContainerLost;
@@ -3339,15 +3344,33 @@ void TPortoStat::Populate(TUintMap &m) {
     m["layer_import"] = Statistics->LayerImport;
     m["layer_export"] = Statistics->LayerExport;
     m["layer_remove"] = Statistics->LayerRemove;
+    m["remove_queued"] = Statistics->RemoveQueued;
+    m["remove_reclaimed"] = Statistics->RemoveReclaimed;
 
     m["volumes"] = Statistics->VolumesCount;
     m["volumes_created"] = Statistics->VolumesCreated;
     m["volumes_failed"] = Statistics->VolumesFailed;
+    m["volumes_pooled"] = Statistics->VolumesPooled;
+    m["volume_pool_hits"] = Statistics->VolumePoolHits;
     m["volume_links"] = Statistics->VolumeLinks;
     m["volume_links_mounted"] = Statistics->VolumeLinksMounted;
     m["volume_lost"] = Statistics->VolumeLost;
 
+    m["helpers_started"] = Statistics->HelpersStarted;
+    m["helpers_canceled"] = Statistics->HelpersCanceled;
+    m["helpers_cpu_usage_ms"] = Statistics->HelpersCpuUsage / 1000;
+    m["helpers_read_bytes"] = Statistics->HelpersReadBytes;
+    m["helpers_write_bytes"] = Statistics->HelpersWriteBytes;
+    usage = 0;
+    cg = MemorySubsystem.Cgroup(PORTO_HELPERS_CGROUP);
+    if (!MemorySubsystem.Usage(cg, usage))
+        m["helpers_memory_usage_mb"] = usage / 1024 / 1024;
+
     m["networks"] = Statistics->NetworksCount;
+    m["network_sync_longest"] = Statistics->NetworkSyncLongest;
+    m["network_watchdog_overruns"] = Statistics->NetworkWatchdogOverruns;
+    if (CT->Net)
+        m["container_network_sync"] = CT->Net->SyncLatency;
 
     m["clients"] = Statistics->ClientsCount;
     m["clients_connected"] = Statistics->ClientsConnected;
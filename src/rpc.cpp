@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <set>
 
 #include "rpc.hpp"
 #include "client.hpp"
@@ -43,6 +44,7 @@ void TRequest::Classify() {
         Req.has_asyncwait() ||
         Req.has_convertpath() ||
         Req.has_locateprocess() ||
+        Req.has_openstream() ||
         Req.has_getsystem();
 
     IoReq =
@@ -117,6 +119,22 @@ void TRequest::Parse() {
     } else if (Req.has_start()) {
         Cmd = "Start";
         Arg = Req.start().name();
+    } else if (Req.has_startbatch()) {
+        Cmd = "StartBatch";
+        for (auto &name: Req.startbatch().name())
+            opts.push_back(name);
+        if (Req.startbatch().subtree())
+            opts.push_back("subtree=true");
+    } else if (Req.has_stopbatch()) {
+        Cmd = "StopBatch";
+        for (auto &name: Req.stopbatch().name())
+            opts.push_back(name);
+        if (Req.stopbatch().has_timeout_ms())
+            opts.push_back(fmt::format("timeout={} ms", Req.stopbatch().timeout_ms()));
+    } else if (Req.has_destroybatch()) {
+        Cmd = "DestroyBatch";
+        for (auto &name: Req.destroybatch().name())
+            opts.push_back(name);
     } else if (Req.has_stop()) {
         Cmd = "Stop";
         Arg = Req.stop().name();
@@ -254,6 +272,10 @@ void TRequest::Parse() {
     } else if (Req.has_locateprocess()) {
         Cmd = "LocateProcess";
         opts = { "pid=" + std::to_string(Req.locateprocess().pid()), "comm=" + Req.locateprocess().comm() };
+    } else if (Req.has_openstream()) {
+        Cmd = "OpenStream";
+        Arg = Req.openstream().name();
+        opts = { "stream=" + Req.openstream().stream() };
     } else if (Req.has_getsystem()) {
         Cmd = "GetSystem";
     } else if (Req.has_setsystem()) {
@@ -319,6 +341,8 @@ static std::string ResponseAsString(const rpc::TContainerResponse &resp) {
             ret = "AsyncWait " + resp.asyncwait().name() + " state=" + resp.asyncwait().state();
     } else if (resp.has_convertpath())
         ret = resp.convertpath().path();
+    else if (resp.has_openstream())
+        ret = fmt::format("offset={}", resp.openstream().offset());
     else
         ret = "Ok";
 
@@ -364,6 +388,184 @@ static noinline TError StartContainer(const rpc::TContainerStartRequest &req) {
     return ct->Start();
 }
 
+static void BatchResult(rpc::TContainerBatchResponse *batch,
+                        const std::string &name, const TError &error) {
+    auto res = batch->add_result();
+    res->set_name(name);
+    res->set_error(error.Error);
+    res->set_errormsg(error.Message());
+}
+
+/* Resolves names, unresolved are reported into batch response right away */
+static TError ResolveContainers(const google::protobuf::RepeatedPtrField<std::string> &names,
+                                std::vector<std::shared_ptr<TContainer>> &cts,
+                                rpc::TContainerBatchResponse *batch) {
+    std::set<TContainer *> seen;
+
+    if (CL->AccessLevel <= EAccessLevel::ReadOnly)
+        return TError(EError::Permission, "Write access denied");
+
+    for (auto &name: names) {
+        std::shared_ptr<TContainer> ct;
+        TError error;
+
+        auto lock = LockContainers();
+        error = CL->ResolveContainer(name, ct);
+        if (!error)
+            error = CL->CanControl(*ct);
+        lock.unlock();
+
+        if (error)
+            BatchResult(batch, name, error);
+        else if (seen.insert(ct.get()).second)
+            cts.push_back(ct);
+    }
+
+    return OK;
+}
+
+static noinline TError StartContainers(const rpc::TContainerStartBatchRequest &req,
+                                       rpc::TContainerResponse &rsp) {
+    std::vector<std::shared_ptr<TContainer>> named, cts;
+    std::vector<TError> result;
+    std::set<TContainer *> seen;
+    auto batch = rsp.mutable_batch();
+
+    TError error = ResolveContainers(req.name(), named, batch);
+    if (error)
+        return error;
+
+    for (auto &ct: named) {
+        std::list<std::shared_ptr<TContainer>> list = { ct };
+        std::set<TContainer *> denied;
+
+        if (req.subtree()) {
+            list = ct->Subtree();
+            list.reverse();
+        }
+
+        for (auto &it: list) {
+            if (it != ct && it->State != EContainerState::Stopped)
+                continue;
+
+            /* Descendants could belong to other users */
+            if (it != ct) {
+                if (denied.count(it->Parent.get())) {
+                    denied.insert(it.get());
+                    BatchResult(batch, CL->RelativeName(it->Name),
+                                TError(EError::InvalidState, "Parent {} failed", it->Parent->Name));
+                    continue;
+                }
+
+                auto lock = LockContainers();
+                error = CL->CanControl(*it);
+                lock.unlock();
+
+                if (error) {
+                    denied.insert(it.get());
+                    BatchResult(batch, CL->RelativeName(it->Name), error);
+                    continue;
+                }
+            }
+
+            if (seen.insert(it.get()).second)
+                cts.push_back(it);
+        }
+    }
+
+    TContainer::BatchAction(cts, result, true, true, [](std::shared_ptr<TContainer> &ct) {
+        return ct->Start();
+    });
+
+    for (size_t i = 0; i < cts.size(); i++)
+        BatchResult(batch, CL->RelativeName(cts[i]->Name), result[i]);
+
+    return OK;
+}
+
+/* Containers inside of others in batch are handled together with them */
+static void DropNested(std::vector<std::shared_ptr<TContainer>> &cts,
+                       std::vector<std::shared_ptr<TContainer>> &nested) {
+    std::set<TContainer *> set;
+
+    for (auto &ct: cts)
+        set.insert(ct.get());
+
+    for (auto it = cts.begin(); it != cts.end(); ) {
+        bool inside = false;
+        for (auto p = (*it)->Parent; p && !inside; p = p->Parent)
+            inside = set.count(p.get());
+        if (inside) {
+            nested.push_back(*it);
+            it = cts.erase(it);
+        } else
+            ++it;
+    }
+}
+
+/* Nested containers share result with their batched ancestor */
+static void ReportBatch(rpc::TContainerBatchResponse *batch,
+                        const std::vector<std::shared_ptr<TContainer>> &cts,
+                        const std::vector<TError> &result,
+                        const std::vector<std::shared_ptr<TContainer>> &nested) {
+    for (size_t i = 0; i < cts.size(); i++)
+        BatchResult(batch, CL->RelativeName(cts[i]->Name), result[i]);
+
+    for (auto &ct: nested) {
+        for (size_t i = 0; i < cts.size(); i++) {
+            if (ct->IsChildOf(*cts[i])) {
+                BatchResult(batch, CL->RelativeName(ct->Name), result[i]);
+                break;
+            }
+        }
+    }
+}
+
+static noinline TError StopContainers(const rpc::TContainerStopBatchRequest &req,
+                                      rpc::TContainerResponse &rsp) {
+    std::vector<std::shared_ptr<TContainer>> cts, nested;
+    std::vector<TError> result;
+    auto batch = rsp.mutable_batch();
+
+    TError error = ResolveContainers(req.name(), cts, batch);
+    if (error)
+        return error;
+
+    DropNested(cts, nested);
+
+    uint64_t timeout_ms = req.has_timeout_ms() ?
+        req.timeout_ms() : config().container().stop_timeout_ms();
+
+    TContainer::BatchAction(cts, result, false, true, [timeout_ms](std::shared_ptr<TContainer> &ct) {
+        return ct->Stop(timeout_ms);
+    });
+
+    ReportBatch(batch, cts, result, nested);
+
+    return OK;
+}
+
+static noinline TError DestroyContainers(const rpc::TContainerDestroyBatchRequest &req,
+                                         rpc::TContainerResponse &rsp) {
+    std::vector<std::shared_ptr<TContainer>> cts, nested;
+    std::vector<TError> result;
+    auto batch = rsp.mutable_batch();
+
+    TError error = ResolveContainers(req.name(), cts, batch);
+    if (error)
+        return error;
+
+    DropNested(cts, nested);
+
+    TContainer::BatchAction(cts, result, false, true, [](std::shared_ptr<TContainer> &ct) {
+        return ct->Destroy();
+    });
+
+    ReportBatch(batch, cts, result, nested);
+
+    return OK;
+}
+
 noinline TError StopContainer(const rpc::TContainerStopRequest &req) {
     std::shared_ptr<TContainer> ct;
     TError error = CL->WriteContainer(req.name(), ct);
@@ -1003,6 +1205,13 @@ noinline TError ListLayers(const rpc::TLayerListRequest &req,
         desc->set_owner_group(layer.Owner.Group());
         desc->set_private_value(layer.Private);
         desc->set_last_usage(layer.LastUsage());
+        if (req.space_usage()) {
+            uint64_t used, shared;
+            if (!layer.SpaceUsage(used, shared)) {
+                desc->set_space_used(used);
+                desc->set_space_shared(shared);
+            }
+        }
     }
 
     return error;
@@ -1237,6 +1446,39 @@ noinline TError SetSymlink(const rpc::TSetSymlinkRequest &req) {
     return ct->Save();
 }
 
+noinline TError OpenStream(const rpc::TContainerOpenStreamRequest &req,
+                           rpc::TContainerResponse &rsp, TFile &file) {
+    std::shared_ptr<TContainer> ct;
+    TStdStream *stream;
+
+    TError error = CL->ReadContainer(req.name(), ct);
+    if (error)
+        return error;
+
+    if (req.stream() == "stdout")
+        stream = &ct->Stdout;
+    else if (req.stream() == "stderr")
+        stream = &ct->Stderr;
+    else
+        return TError(EError::InvalidValue, "unknown stream {}", req.stream());
+
+    ct->LockStateRead();
+
+    if (ct->State == EContainerState::Stopped ||
+            ct->State == EContainerState::Starting)
+        error = TError(EError::InvalidState, "{} is not available in {} state",
+                       req.stream(), TContainer::StateName(ct->State));
+    else
+        error = stream->OpenRead(*ct, file);
+
+    if (!error)
+        rsp.mutable_openstream()->set_offset(stream->Offset);
+
+    ct->UnlockState();
+
+    return error;
+}
+
 noinline static TError GetSystemProperties(const rpc::TGetSystemRequest *, rpc::TGetSystemResponse *rsp) {
     rsp->set_porto_version(PORTO_VERSION);
     rsp->set_porto_revision(PORTO_REVISION);
@@ -1342,10 +1584,14 @@ TError TRequest::Check() {
     return OK;
 }
 
+static std::atomic<uint64_t> RequestSeq;
+
 void TRequest::Handle() {
     rpc::TContainerResponse rsp;
+    TFile passFd;
     TError error;
 
+    LogRequestId = ++RequestSeq;
     Client->StartRequest();
     StartTime = GetCurrentTimeMs();
 
@@ -1379,6 +1625,12 @@ void TRequest::Handle() {
         error = GetContainerCombined(Req.get(), rsp);
     else if (Req.has_start())
         error = StartContainer(Req.start());
+    else if (Req.has_startbatch())
+        error = StartContainers(Req.startbatch(), rsp);
+    else if (Req.has_stopbatch())
+        error = StopContainers(Req.stopbatch(), rsp);
+    else if (Req.has_destroybatch())
+        error = DestroyContainers(Req.destroybatch(), rsp);
     else if (Req.has_stop())
         error = StopContainer(Req.stop());
     else if (Req.has_pause())
@@ -1451,6 +1703,8 @@ void TRequest::Handle() {
         error = SetSymlink(Req.setsymlink());
     else if (Req.has_locateprocess())
         error = LocateProcess(Req.locateprocess(), rsp);
+    else if (Req.has_openstream())
+        error = OpenStream(Req.openstream(), rsp, passFd);
     else if (Req.has_getsystem())
         error = GetSystemProperties(&Req.getsystem(), rsp.mutable_getsystem());
     else if (Req.has_setsystem())
@@ -1480,8 +1734,10 @@ void TRequest::Handle() {
         Statistics->LongestRoRequest = RequestTime;
     }
 
-    if (error == EError::Queued)
+    if (error == EError::Queued) {
+        LogRequestId = 0;
         return;
+    }
 
     if (error) {
         Statistics->RequestsFailed++;
@@ -1517,11 +1773,13 @@ void TRequest::Handle() {
 
     auto lock = Client->Lock();
     Client->Processing = false;
-    error = Client->QueueResponse(rsp);
+    error = Client->QueueResponse(rsp, &passFd);
     if (!error && !Client->Sending)
         error = Client->SendResponse(true);
     if (error)
         L_WRN("Cannot send response for {} : {}", Client->Id, error);
+
+    LogRequestId = 0;
 }
 
 class TRequestQueue {
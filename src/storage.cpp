@@ -5,7 +5,13 @@
 #include "filesystem.hpp"
 #include "client.hpp"
 #include <algorithm>
+#include <set>
+#include <map>
 #include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <functional>
 #include "util/unix.hpp"
 #include "util/log.hpp"
 #include "util/string.hpp"
@@ -42,6 +48,17 @@ static std::condition_variable StorageCv;
 static TUintMap PlaceLoad;
 static TUintMap PlaceLoadLimit;
 
+struct TRemoveJob {
+    TPath Place;
+    TPath Path;
+    EStorageType Type;
+};
+
+static std::list<TRemoveJob> RemoveQueue;
+static std::vector<std::thread> RemoveThreads;
+static bool ReclaimerRunning = false; /* protected with VolumesMutex */
+static std::atomic<bool> RemoveStop(false);
+
 TStorage::TStorage(EStorageType type, const TPath &place, const std::string &name) {
     Type = type;
     Place = place;
@@ -80,29 +97,153 @@ TStorage::TStorage(EStorageType type, const TPath &place, const std::string &nam
 }
 
 void TStorage::Init() {
+    TFile::SetRemoveThreads(config().volumes().remove_tree_threads());
+
     if (StringToUintMap(config().volumes().place_load_limit(), PlaceLoadLimit))
         PlaceLoadLimit = {{"default", 1}};
 }
 
-void TStorage::IncPlaceLoad(const TPath &place) {
-    auto lock = LockVolumes();
+static std::string PlaceLoadId(const TPath &place) {
     auto id = place.ToString();
     if (!PlaceLoadLimit.count(id))
         id = "default";
+    return id;
+}
+
+void TStorage::IncPlaceLoad(const TPath &place) {
+    auto lock = LockVolumes();
+    auto id = PlaceLoadId(place);
     StorageCv.wait(lock, [&]{return PlaceLoad[id] < PlaceLoadLimit[id];});
     PlaceLoad[id]++;
 }
 
+static bool TryIncPlaceLoad(const TPath &place) {
+    PORTO_LOCKED(VolumesMutex);
+    auto id = PlaceLoadId(place);
+    if (PlaceLoad[id] >= PlaceLoadLimit[id])
+        return false;
+    PlaceLoad[id]++;
+    return true;
+}
+
 void TStorage::DecPlaceLoad(const TPath &place) {
     auto lock = LockVolumes();
-    auto id = place.ToString();
-    if (!PlaceLoadLimit.count(id))
-        id = "default";
+    auto id = PlaceLoadId(place);
     if (PlaceLoad[id]-- <= 1)
         PlaceLoad.erase(id);
     StorageCv.notify_all();
 }
 
+/* Path must be already renamed to _remove_ and added into ActivePaths */
+static void QueueRemove(const TPath &place, const TPath &path, EStorageType type) {
+    PORTO_LOCKED(VolumesMutex);
+    L_ACT("Queue removal {}", path);
+    RemoveQueue.push_back({place, path, type});
+    Statistics->RemoveQueued++;
+    StorageCv.notify_all();
+}
+
+static TError VisitContent(const TFile &dir, const std::string &name, const struct stat &st,
+                           std::mutex &mutex, std::set<std::string> &content);
+
+TError TStorage::Reclaim(const TPath &place, const TPath &path, EStorageType type) {
+    uint64_t start = GetCurrentTimeMs();
+    std::atomic<uint64_t> size(0);
+    std::set<std::string> content;
+    std::mutex content_mutex;
+    bool dedup = (type == EStorageType::Layer || type == EStorageType::Meta) &&
+        (place / PORTO_CONTENT).Exists();
+    TError error;
+
+    L_ACT("Reclaim {}", path);
+
+    /* Size is counted while removing, stop leaves the rest to Cleanup */
+    error = RemoveRecursive(path, [&](const TFile &dir, const std::string &name,
+                                      const struct stat &st) {
+        if (RemoveStop)
+            return TError(EError::Busy, "Removal stopped");
+        size += st.st_blocks * 512ull;
+        if (dedup)
+            return VisitContent(dir, name, st, content_mutex, content);
+        return OK;
+    });
+    if (error && !RemoveStop) {
+        L_VERBOSE("Cannot remove storage {}: {}", path, error);
+        error = path.RemoveAll();
+    }
+
+    Statistics->RemoveReclaimed += size;
+
+    if (error && RemoveStop) {
+        L("Removal stopped {} reclaimed {} in {} ms", path,
+          StringFormatSize(size), GetCurrentTimeMs() - start);
+    } else if (error) {
+        L_WRN("Cannot remove storage {}: {}", path, error);
+    } else {
+        L("Reclaimed {} {} in {} ms", path, StringFormatSize(size),
+          GetCurrentTimeMs() - start);
+    }
+
+    if (!content.empty())
+        CollectContent(place, std::vector<std::string>(content.begin(), content.end()));
+
+    return error;
+}
+
+void TStorage::Reclaimer(int index) {
+    SetProcessName(fmt::format("portod-RM{}", index));
+    CL = &SystemClient;
+
+    auto lock = LockVolumes();
+    while (!RemoveStop) {
+        /* Pick first job whose place is not overloaded */
+        auto job = std::find_if(RemoveQueue.begin(), RemoveQueue.end(),
+                [](const TRemoveJob &job) { return TryIncPlaceLoad(job.Place); });
+        if (job == RemoveQueue.end()) {
+            StorageCv.wait(lock);
+            continue;
+        }
+
+        TRemoveJob current = *job;
+        RemoveQueue.erase(job);
+        lock.unlock();
+
+        (void)Reclaim(current.Place, current.Path, current.Type);
+        DecPlaceLoad(current.Place);
+
+        lock.lock();
+        ActivePaths.remove(current.Path);
+        Statistics->RemoveQueued--;
+    }
+
+    CL = nullptr;
+}
+
+void TStorage::StartReclaimer() {
+    if (!config().volumes().async_remove())
+        return;
+
+    RemoveStop = false;
+    for (unsigned index = 0; index < std::max(1u, config().volumes().remove_threads()); index++)
+        RemoveThreads.emplace_back(&TStorage::Reclaimer, index);
+
+    auto lock = LockVolumes();
+    ReclaimerRunning = true;
+}
+
+/* Pending removals are resumed by Cleanup after restart */
+void TStorage::StopReclaimer() {
+    auto lock = LockVolumes();
+    ReclaimerRunning = false;
+    RemoveStop = true;
+    StorageCv.notify_all();
+    lock.unlock();
+
+    for (auto &thread: RemoveThreads)
+        thread.join();
+    RemoveThreads.clear();
+}
+
 /* FIXME racy. rewrite with openat... etc */
 TError TStorage::Cleanup(const TPath &place, EStorageType type, unsigned perms) {
     TPath base;
@@ -183,6 +324,12 @@ TError TStorage::Cleanup(const TPath &place, EStorageType type, unsigned perms)
 
             path = dirent.RealPath();
 
+            if (StringStartsWith(name, REMOVE_PREFIX) && config().volumes().async_remove()) {
+                ActivePaths.push_back(path);
+                QueueRemove(place, path, type);
+                continue;
+            }
+
         } else if (path.IsRegularStrict()) {
             if (type != EStorageType::Volume && StringStartsWith(name, PRIVATE_PREFIX)) {
                 std::string tail = name.substr(std::string(PRIVATE_PREFIX).size());
@@ -338,6 +485,9 @@ TError TStorage::CheckUsage() {
                 if (Place == it.second->Place && Name == layer)
                     return TError(EError::Busy, "Layer " + Name + " in use by volume " + it.second->Path.ToString());
         }
+        auto pooled = TVolume::FindPooledLayer(Place, Name);
+        if (pooled)
+            return TError(EError::Busy, "Layer " + Name + " in use by pre-built volume " + pooled->Path.ToString());
     }
 
     if (Type == EStorageType::Storage) {
@@ -456,6 +606,8 @@ static TError Compression(const TPath &archive, const TFile &arc,
             goto xz;
         if (compress == "tgz" || compress == "tar.gz")
             goto gz;
+        if (compress == "tzst" || compress == "tar.zst" || compress == "tar.zstd")
+            goto zst;
         if (compress == "tar")
             goto tar;
         if (StringEndsWith(compress, "squashfs"))
@@ -472,6 +624,8 @@ static TError Compression(const TPath &archive, const TFile &arc,
                 goto xz;
             if (!strncmp(magic, "\x1F\x8B\x08", 3))
                 goto gz;
+            if (!strncmp(magic, "\x28\xB5\x2F\xFD", 4))
+                goto zst;
             if (!strncmp(magic, "hsqs", 4))
                 goto squash;
         }
@@ -491,6 +645,10 @@ static TError Compression(const TPath &archive, const TFile &arc,
     if (StringEndsWith(name, ".gz") || StringEndsWith(name, ".tgz"))
         goto gz;
 
+    if (StringEndsWith(name, ".zst") || StringEndsWith(name, ".tzst") ||
+            StringEndsWith(name, ".zstd"))
+        goto zst;
+
     if (StringEndsWith(name, ".squash") || StringEndsWith(name, ".squashfs"))
         goto squash;
 
@@ -498,7 +656,11 @@ tar:
     option = "--no-auto-compress";
     return OK;
 gz:
-    if (!arc && config().volumes().parallel_compression()) {
+    /*
+     * Gzip stream cannot be inflated in parallel: pigz inflates in one
+     * thread but reads, writes and checks crc in others.
+     */
+    if (config().volumes().parallel_compression()) {
         if (TPath("/usr/bin/pigz").Exists()) {
             option = "--use-compress-program=pigz";
             return OK;
@@ -507,7 +669,12 @@ gz:
     option = "--gzip";
     return OK;
 xz:
-    if (!arc && config().volumes().parallel_compression()) {
+    if (config().volumes().parallel_compression()) {
+        /* xz >= 5.4 decompresses multi-block streams in parallel */
+        if (arc) {
+            option = "--use-compress-program=xz -T0";
+            return OK;
+        }
         if (TPath("/usr/bin/pixz").Exists()) {
             option = "--use-compress-program=pixz";
             return OK;
@@ -515,6 +682,19 @@ xz:
     }
     option = "--xz";
     return OK;
+zst:
+    option = "--use-compress-program=zstd";
+    if (!arc) {
+        /* Compression */
+        if (config().volumes().parallel_compression())
+            option += " -T0";
+        if (config().volumes().zstd_window_log())
+            option += fmt::format(" --long={}", config().volumes().zstd_window_log());
+    } else {
+        /* Accept any window size, memory is bounded by archive */
+        option += " --long=31";
+    }
+    return OK;
 squash:
     format = "squashfs";
     auto sep = compress.find('.');
@@ -538,7 +718,86 @@ static bool TarSupportsXattrs() {
     return result;
 }
 
+/* Files untouched since checksum was saved keep the same stamp */
+static std::string ChecksumStamp(const struct stat &st) {
+    return fmt::format("{}.{}:{}:{}", st.st_mtim.tv_sec, st.st_mtim.tv_nsec,
+                       st.st_size, st.st_ino);
+}
+
+static TError SaveFileChecksum(const TPath &path, const std::string &stamp,
+                               std::string *sum = nullptr) {
+    std::string md5, xxh64;
+    TError error;
+    TFile file;
+
+    error = file.OpenRead(path);
+    if (error)
+        return error;
+
+    error = Md5Sum(file, md5, config().volumes().checksum_xxh64() ? &xxh64 : nullptr);
+    if (error)
+        return error;
+
+    error = file.SetXAttr("user.porto.md5sum", md5);
+    if (error)
+        return error;
+
+    if (xxh64.size()) {
+        error = file.SetXAttr("user.porto.xxh64sum", xxh64);
+        if (error)
+            return error;
+    }
+
+    if (sum)
+        *sum = md5;
+
+    return file.SetXAttr("user.porto.checksum_stamp", stamp);
+}
+
+/* Runs fn(0..count-1) in volumes.checksum_threads, returns first error */
+static TError ParallelFiles(size_t count, const std::function<TError(size_t)> &fn) {
+    unsigned nr_threads = std::max(1u, config().volumes().checksum_threads());
+    nr_threads = std::min<size_t>(nr_threads, count);
+    TError error;
+
+    if (nr_threads <= 1) {
+        for (size_t index = 0; index < count; index++) {
+            error = fn(index);
+            if (error)
+                return error;
+        }
+        return OK;
+    }
+
+    std::atomic<size_t> next(0);
+    std::mutex errorMutex;
+    std::vector<std::thread> threads;
+
+    for (unsigned i = 0; i < nr_threads; i++) {
+        threads.emplace_back([&] {
+            while (1) {
+                size_t index = next++;
+                if (index >= count)
+                    break;
+                TError err = fn(index);
+                if (err) {
+                    std::lock_guard<std::mutex> guard(errorMutex);
+                    if (!error)
+                        error = err;
+                    next = count;
+                }
+            }
+        });
+    }
+
+    for (auto &thread: threads)
+        thread.join();
+
+    return error;
+}
+
 TError TStorage::SaveChecksums() {
+    std::vector<std::pair<TPath, std::string>> files;
     TPathWalk walk;
     TError error;
 
@@ -558,17 +817,237 @@ TError TStorage::SaveChecksums() {
             Size += walk.Stat->st_blocks * 512ull;
         if (!S_ISREG(walk.Stat->st_mode))
             continue;
-        TFile file;
-        error = file.OpenRead(walk.Path);
+
+        std::string stamp = ChecksumStamp(*walk.Stat);
+        std::string old, md5;
+        TPath path(walk.Path);
+        if (!path.GetXAttr("user.porto.checksum_stamp", old) && old == stamp &&
+                !path.GetXAttr("user.porto.md5sum", md5) &&
+                (!config().volumes().checksum_xxh64() ||
+                 !path.GetXAttr("user.porto.xxh64sum", md5)))
+            continue;
+
+        files.emplace_back(path, stamp);
+    }
+
+    return ParallelFiles(files.size(), [&](size_t index) {
+        return SaveFileChecksum(files[index].first, files[index].second);
+    });
+}
+
+/*
+ * Content store keeps one hardlink for each unique file content and
+ * metadata. Layers link their files into it, so reference count is
+ * the inode link count and removing layer never affects others.
+ * Name covers everything hardlinks share: data, owner, mode, mtime
+ * and xattrs including acls, except checksums derived from data.
+ */
+static TError ContentName(const TFile &file, const struct stat &st,
+                          const std::string &md5, std::string &name) {
+    std::vector<std::string> xattrs;
+    std::string attrs, value;
+    TError error;
+
+    error = file.ListXAttr(xattrs);
+    if (error)
+        return error;
+
+    std::sort(xattrs.begin(), xattrs.end());
+
+    for (auto &xattr: xattrs) {
+        if (StringStartsWith(xattr, "user.porto."))
+            continue;
+        error = file.GetXAttr(xattr, value);
         if (error)
             return error;
-        std::string sum;
-        error = Md5Sum(file, sum);
+        attrs += fmt::format("{}={}:", xattr, value.size()) + value;
+    }
+
+    name = fmt::format("{}-{}-{:o}-{}-{}-{}.{}", md5, st.st_size,
+                       st.st_mode & 07777, st.st_uid, st.st_gid,
+                       st.st_mtim.tv_sec, st.st_mtim.tv_nsec);
+    if (attrs.size())
+        name += "-" + Md5Sum(attrs);
+
+    return OK;
+}
+
+static TError DedupFile(const TPath &store, const TPath &path, const struct stat &st,
+                        const std::string &md5, uint64_t &saved) {
+    TPath temp = path.DirName() / (std::string(LAYER_TMP) + path.BaseName());
+    std::string name;
+    TError error;
+    TFile file;
+
+    error = file.Open(path, O_RDONLY | O_NOFOLLOW | O_NOCTTY | O_CLOEXEC);
+    if (!error)
+        error = ContentName(file, st, md5, name);
+    if (error)
+        return error;
+
+    TPath content = store / name;
+
+    for (int retry = 0; retry < 3; retry++) {
+        error = temp.Hardlink(content);
+        if (!error) {
+            error = temp.Rename(path);
+            if (error) {
+                (void)temp.Unlink();
+                return error;
+            }
+            saved += st.st_blocks * 512ull;
+            return OK;
+        }
+
+        /* EXDEV, EMLINK and so on: leave file as is */
+        if (error.Errno != ENOENT)
+            return OK;
+
+        error = content.Hardlink(path);
+        if (!error || error.Errno != EEXIST)
+            return error;
+    }
+
+    return OK;
+}
+
+TError TStorage::DedupLayer(const TPath &root) {
+    std::vector<std::pair<TPath, struct stat>> files;
+    TPath store = Place / PORTO_CONTENT;
+    std::atomic<uint64_t> saved(0);
+    TPathWalk walk;
+    TError error;
+
+    if (!store.Exists()) {
+        error = store.Mkdir(0700);
+        if (error && error.Errno != EEXIST)
+            return error;
+        error = store.Chown(RootUser, PortoGroup);
         if (error)
             return error;
-        error = file.SetXAttr("user.porto.md5sum", sum);
+    }
+
+    error = walk.OpenScan(root);
+    if (error)
+        return error;
+
+    while (1) {
+        error = walk.Next();
         if (error)
             return error;
+        if (!walk.Path)
+            break;
+
+        /* Keep hardlinks made by archive and files already in store */
+        if (!S_ISREG(walk.Stat->st_mode) || walk.Stat->st_nlink != 1 ||
+                !walk.Stat->st_size)
+            continue;
+
+        files.emplace_back(walk.Path, *walk.Stat);
+    }
+
+    /* Checksums from archive cannot be trusted, always recompute */
+    error = ParallelFiles(files.size(), [&](size_t index) {
+        auto &file = files[index];
+        uint64_t bytes = 0;
+        std::string md5;
+        TError err;
+
+        err = SaveFileChecksum(file.first, ChecksumStamp(file.second), &md5);
+        if (err)
+            return err;
+
+        err = DedupFile(store, file.first, file.second, md5, bytes);
+        if (err)
+            L_VERBOSE("Cannot dedup {}: {}", file.first, err);
+        saved += bytes;
+
+        return OK;
+    });
+
+    if (saved)
+        L("Layer {} deduplicated {}", Name, StringFormatSize(saved));
+
+    return error;
+}
+
+/* Drops store entries which are not linked into any layer anymore */
+void TStorage::CollectContent(const TPath &place, const std::vector<std::string> &names) {
+    TPath store = place / PORTO_CONTENT;
+    struct stat st;
+
+    for (auto &name: names) {
+        TPath path = store / name;
+        if (!path.StatStrict(st) && st.st_nlink == 1) {
+            TError error = path.Unlink();
+            if (error && error.Errno != ENOENT)
+                L_WRN("Cannot remove content {}: {}", path, error);
+        }
+    }
+}
+
+/* Remembers store entries of removed file, checked after removal */
+static TError VisitContent(const TFile &dir, const std::string &name, const struct stat &st,
+                           std::mutex &mutex, std::set<std::string> &content) {
+    std::string md5, key;
+    TFile file;
+
+    if (!S_ISREG(st.st_mode) || st.st_nlink < 2)
+        return OK;
+
+    if (file.OpenAt(dir, name, O_RDONLY | O_NOFOLLOW | O_NONBLOCK | O_NOCTTY | O_CLOEXEC, 0) ||
+            file.GetXAttr("user.porto.md5sum", md5) ||
+            ContentName(file, st, md5, key))
+        return OK;
+
+    std::lock_guard<std::mutex> guard(mutex);
+    content.insert(key);
+    return OK;
+}
+
+/* Files linked only from this layer and content store are exclusive */
+TError TStorage::SpaceUsage(uint64_t &exclusive, uint64_t &shared) const {
+    struct TLinks {
+        nlink_t Total;
+        nlink_t Inside;
+        uint64_t Size;
+    };
+    std::map<ino_t, TLinks> links;
+    bool store = (Place / PORTO_CONTENT).Exists();
+    TPathWalk walk;
+    TError error;
+
+    exclusive = shared = 0;
+
+    error = walk.OpenScan(Path);
+    if (error)
+        return error;
+
+    while (1) {
+        error = walk.Next();
+        if (error)
+            return error;
+        if (!walk.Path)
+            break;
+        if (walk.Postorder)
+            continue;
+        if (S_ISDIR(walk.Stat->st_mode) || walk.Stat->st_nlink == 1) {
+            exclusive += walk.Stat->st_blocks * 512ull;
+            continue;
+        }
+        auto &link = links[walk.Stat->st_ino];
+        link.Total = walk.Stat->st_nlink;
+        link.Inside++;
+        link.Size = walk.Stat->st_blocks * 512ull;
+    }
+
+    /* Count each inode once, store holds one more link of deduplicated files */
+    for (auto &it: links) {
+        auto &link = it.second;
+        if (link.Total - link.Inside > (store ? 1u : 0u))
+            shared += link.Size;
+        else
+            exclusive += link.Size;
     }
 
     return OK;
@@ -613,6 +1092,9 @@ TError TStorage::ImportArchive(const TPath &archive, const std::string &compress
     if (error)
         return error;
 
+    if (merge && Type == EStorageType::Layer)
+        TVolume::DropPooledLayer(Place, Name);
+
     auto lock = LockVolumes();
 
     TFile import_dir;
@@ -673,12 +1155,23 @@ TError TStorage::ImportArchive(const TPath &archive, const std::string &compress
                         "--xattrs-include=trusted.overlay.*",
                         "--xattrs-include=user.*"});
 
-        error = RunCommand(args, import_dir, arc, TFile());
+        error = RunCommand(args, import_dir, arc, TFile(), HelperCapabilities, true);
     } else if (compress_format == "squashfs") {
+        int processors = 1;
+
+        /* unsquashfs -force truncates existing files in place */
+        if (merge && Type == EStorageType::Layer && (Place / PORTO_CONTENT).Exists()) {
+            error = TError(EError::NotSupported, "Cannot merge squashfs into deduplicated place");
+            goto err;
+        }
+
+        if (config().volumes().parallel_compression())
+            processors = GetNumCores();
+
         TTuple args = { "unsquashfs",
                         "-force",
                         "-no-progress",
-                        "-processors", "1",
+                        "-processors", std::to_string(processors),
                         "-dest", temp.ToString(),
                         archive.ToString() };
 
@@ -687,7 +1180,7 @@ TError TStorage::ImportArchive(const TPath &archive, const std::string &compress
         if (error)
             return error;
 
-        error = RunCommand(args, parent_dir);
+        error = RunCommand(args, parent_dir, TFile(), TFile(), HelperCapabilities, true);
     } else
         error = TError(EError::NotSupported, "Unsuported format " + compress_format);
 
@@ -700,6 +1193,13 @@ TError TStorage::ImportArchive(const TPath &archive, const std::string &compress
             goto err;
     }
 
+    if (Type == EStorageType::Layer && compress_format == "tar" &&
+            config().volumes().layer_dedup()) {
+        error = DedupLayer(temp);
+        if (error)
+            L_WRN("Cannot deduplicate layer {}: {}", Name, error);
+    }
+
     if (!Owner.IsUnknown()) {
         error = SaveOwner(Owner);
         if (error)
@@ -812,14 +1312,14 @@ TError TStorage::ExportArchive(const TPath &archive, const std::string &compress
         if (TarSupportsXattrs())
             args.insert(args.begin() + 4, "--xattrs");
 
-        error = RunCommand(args, dir, TFile(), arc);
+        error = RunCommand(args, dir, TFile(), arc, HelperCapabilities, true);
     } else if (compress_format == "squashfs") {
         TTuple args = { "mksquashfs", Path.ToString(),
                         archive.BaseName(),
                         "-noappend",
                         "-comp", compress_option };
 
-        error = RunCommand(args, dir, TFile());
+        error = RunCommand(args, dir, TFile(), TFile(), HelperCapabilities, true);
     } else
         error = TError(EError::NotSupported, "Unsupported format " + compress_format);
 
@@ -857,6 +1357,9 @@ TError TStorage::Remove(bool weak) {
     if (error && !weak)
         return TError(error, "Cannot remove {}", Path);
 
+    if (Type == EStorageType::Layer)
+        TVolume::DropPooledLayer(Place, Name);
+
     auto lock = LockVolumes();
 
     error = CheckUsage();
@@ -871,7 +1374,9 @@ TError TStorage::Remove(bool weak) {
     }
 
     TFile temp_dir;
-    temp = TempPath(REMOVE_PREFIX + std::to_string(RemoveCounter++));
+    do
+        temp = TempPath(REMOVE_PREFIX + std::to_string(RemoveCounter++));
+    while (temp.Exists());
 
     error = Path.Rename(temp);
     if (!error) {
@@ -887,7 +1392,6 @@ TError TStorage::Remove(bool weak) {
     if (error)
         return error;
 
-    IncPlaceLoad(Place);
     Statistics->LayerRemove++;
 
     if (Type == EStorageType::Meta) {
@@ -897,14 +1401,16 @@ TError TStorage::Remove(bool weak) {
             L_WRN("Cannot destroy quota {}: {}", temp, error);
     }
 
-    error = RemoveRecursive(temp);
-    if (error) {
-        L_VERBOSE("Cannot remove storage {}: {}", temp, error);
-        error = temp.RemoveAll();
-        if (error)
-            L_WRN("Cannot remove storage {}: {}", temp, error);
+    /* Data is gone for clients, space is reclaimed in background */
+    lock.lock();
+    if (ReclaimerRunning) {
+        QueueRemove(Place, temp, Type);
+        return OK;
     }
+    lock.unlock();
 
+    IncPlaceLoad(Place);
+    error = Reclaim(Place, temp, Type);
     DecPlaceLoad(Place);
 
     lock.lock();
@@ -44,6 +44,7 @@ public:
     TError SetPrivate(const std::string &text);
     TError SavePrivate(const std::string &text);
     TError SaveChecksums();
+    TError SpaceUsage(uint64_t &exclusive, uint64_t &shared) const;
 
     TError CreateMeta(uint64_t space_limit, uint64_t inode_limit);
     TError ResizeMeta(uint64_t space_limit, uint64_t inode_limit);
@@ -52,9 +53,15 @@ public:
     static void Init();
     static void IncPlaceLoad(const TPath &place);
     static void DecPlaceLoad(const TPath &place);
+    static void StartReclaimer();
+    static void StopReclaimer();
 
 private:
     static TError Cleanup(const TPath &place, EStorageType type, unsigned perms);
     TPath TempPath(const std::string &kind);
     TError CheckUsage();
+    TError DedupLayer(const TPath &root);
+    static void CollectContent(const TPath &place, const std::vector<std::string> &names);
+    static TError Reclaim(const TPath &place, const TPath &path, EStorageType type);
+    static void Reclaimer(int index);
 };
@@ -34,11 +34,10 @@ TPath TStdStream::ResolveOutside(const TContainer &container) const {
     return container.RootPath / container.GetCwd() / Path;
 }
 
-TError TStdStream::Open(const TPath &path, const TCred &cred) {
+/* Called in forked or vforked child, must not change stream state */
+TError TStdStream::Open(const TPath &path, const TCred &cred, bool nonblock) const {
     int fd, flags;
 
-    Offset = 0;
-
     if (Stream)
         flags = O_WRONLY | O_APPEND;
     else
@@ -47,6 +46,10 @@ TError TStdStream::Open(const TPath &path, const TCred &cred) {
     /* Never assign controlling terminal at open */
     flags |= O_NOCTTY;
 
+    /* Fifo without peer fails rather than blocks */
+    if (nonblock)
+        flags |= O_NONBLOCK;
+
 retry:
     fd = open(path.c_str(), flags);
     if (fd < 0 && errno == ENOENT && Stream) {
@@ -61,6 +64,11 @@ retry:
     if (fd < 0)
         return TError(EError::InvalidValue, errno, "open " + path.ToString());
 
+    if (nonblock && fcntl(fd, F_SETFL, flags & ~O_NONBLOCK)) {
+        close(fd);
+        return TError::System("fcntl " + path.ToString());
+    }
+
     if (fd != Stream) {
         if (dup2(fd, Stream) < 0) {
             close(fd);
@@ -68,17 +76,15 @@ retry:
                           ", " + std::to_string(Stream) + ")");
         }
         close(fd);
-    } else {
-        Stream = fd;
     }
 
     return OK;
 }
 
 TError TStdStream::OpenOutside(const TContainer &container,
-                               const TClient &client) {
+                               const TClient &client, bool nonblock) const {
     if (IsNull())
-        return Open("/dev/null", container.TaskCred);
+        return Open("/dev/null", container.TaskCred, nonblock);
 
     if (IsRedirect()) {
         int clientFd = -1;
@@ -108,12 +114,31 @@ TError TStdStream::OpenOutside(const TContainer &container,
             return TError(EError::Permission,
                     "Not enough permissions for redirect: " + Path.ToString());
     } else if (Outside)
-        return Open(ResolveOutside(container), container.TaskCred);
+        return Open(ResolveOutside(container), container.TaskCred, nonblock);
 
     return OK;
 }
 
-TError TStdStream::OpenInside(const TContainer &container) {
+/* Opening redirect, fifo or device outside could block for a long time */
+bool TStdStream::MayBlockOutside(const TContainer &container) const {
+    struct stat st;
+
+    if (IsNull())
+        return false;
+
+    if (IsRedirect())
+        return true;
+
+    if (!Outside)
+        return false;
+
+    if (ResolveOutside(container).StatFollow(st))
+        return false;
+
+    return !S_ISREG(st.st_mode);
+}
+
+TError TStdStream::OpenInside(const TContainer &container) const {
     TError error;
 
     if (!Outside && !IsNull() && !IsRedirect())
@@ -142,26 +167,56 @@ TError TStdStream::Remove(const TContainer &container) {
 }
 
 TError TStdStream::Rotate(const TContainer &container) {
+    uint64_t period = config().daemon().log_rotate_ms();
+    uint64_t now = GetCurrentTimeMs();
     TPath path = ResolveOutside(container);
-    if (path.IsEmpty() || !path.IsRegularStrict())
+    uint64_t usage, growth, left;
+    struct stat st;
+    off_t loss = 0;
+    TError error;
+
+    RotateDelayMs = period;
+    RotateIdle = true;
+    RotatePath = "";
+
+    /* Cheap lstat first, file is opened only when it is over limit */
+    if (path.IsEmpty() || path.StatStrict(st) || !S_ISREG(st.st_mode)) {
+        RotateCheckMs = 0;
         return OK;
-    off_t loss;
-    TError error = path.RotateLog(Limit, loss);
-    if (error) {
-        Statistics->LogRotateErrors++;
-        return error;
     }
-    Statistics->LogRotateBytes += loss;
-    Offset += loss;
+
+    usage = (uint64_t)st.st_blocks * 512;
+    growth = usage - std::min(usage, RotateUsage);
+
+    if (usage > Limit) {
+        error = path.RotateLog(Limit, loss);
+        if (error) {
+            Statistics->LogRotateErrors++;
+            return error;
+        }
+        Statistics->LogRotateBytes += loss;
+        Offset += loss;
+        usage -= std::min(usage, (uint64_t)loss);
+    }
+
+    /* Check again at half of time predicted to reach limit */
+    left = Limit - std::min(Limit, usage);
+    if (RotateCheckMs && now > RotateCheckMs && growth)
+        RotateDelayMs = left * (now - RotateCheckMs) / growth / 2;
+    RotateDelayMs = std::max(std::min(RotateDelayMs, period), period / 10);
+
+    RotateIdle = RotateCheckMs && !growth;
+    RotatePath = path;
+
+    RotateCheckMs = now;
+    RotateUsage = usage;
+
     return OK;
 }
 
-TError TStdStream::Read(const TContainer &container, std::string &text,
-                        const std::string &range) const {
-    std::string off = "", lim = "";
-    uint64_t offset, limit;
-    TError error;
+TError TStdStream::OpenRead(const TContainer &container, TFile &file) const {
     TPath path = ResolveOutside(container);
+    TError error;
 
     if (path.IsEmpty())
         return TError(EError::InvalidData, "Data not available");
@@ -170,6 +225,29 @@ TError TStdStream::Read(const TContainer &container, std::string &text,
     if (!path.IsRegularStrict())
         return TError(EError::InvalidData, "File is non-regular");
 
+    error = file.Open(path, O_RDONLY | O_NOCTTY | O_NOFOLLOW | O_CLOEXEC);
+    if (error)
+        return error;
+
+    if (file.RealPath() != path) {
+        file.Close();
+        return TError(EError::Permission, "Real path doesn't match: " + path.ToString());
+    }
+
+    return OK;
+}
+
+TError TStdStream::Read(const TContainer &container, std::string &text,
+                        const std::string &range) const {
+    std::string off = "", lim = "";
+    uint64_t offset, limit;
+    TError error;
+    TFile file;
+
+    error = OpenRead(container, file);
+    if (error)
+        return error;
+
     /* [offset][:limit] */
     if (range.size()) {
         auto sep = range.find(':');
@@ -197,15 +275,6 @@ TError TStdStream::Read(const TContainer &container, std::string &text,
     } else
         limit = Limit;
 
-    TFile file;
-
-    error = file.Open(path, O_RDONLY | O_NOCTTY | O_NOFOLLOW | O_CLOEXEC);
-    if (error)
-        return error;
-
-    if (file.RealPath() != path)
-        return TError(EError::Permission, "Real path doesn't match: " + path.ToString());
-
     uint64_t size = lseek(file.Fd, 0, SEEK_END);
 
     if (size <= offset)
@@ -220,7 +289,7 @@ TError TStdStream::Read(const TContainer &container, std::string &text,
         ssize_t result = pread(file.Fd, &text[0], limit, offset);
 
         if (result < 0)
-            return TError::System("Read " + path.ToString());
+            return TError::System("Read " + file.RealPath().ToString());
 
         if ((uint64_t)result < limit)
             text.resize(result);
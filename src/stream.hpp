@@ -14,6 +14,15 @@ public:
     uint64_t Limit = 0;
     uint64_t Offset = 0;
 
+    /* Rotation is scheduled by predicted time to reach limit */
+    uint64_t RotateCheckMs = 0;
+    uint64_t RotateUsage = 0;
+    uint64_t RotateDelayMs = 0;
+
+    /* Idle stream is checked again after modification, RotatePath is watched */
+    bool RotateIdle = false;
+    TPath RotatePath;
+
     TStdStream(int stream): Stream(stream) { }
 
     void SetOutside(const std::string &path) {
@@ -30,13 +39,16 @@ public:
     bool IsRedirect(void) const;
     TPath ResolveOutside(const TContainer &container) const;
 
-    TError Open(const TPath &path, const TCred &cred);
-    TError OpenOutside(const TContainer &container, const TClient &client);
-    TError OpenInside(const TContainer &container);
+    TError Open(const TPath &path, const TCred &cred, bool nonblock = false) const;
+    TError OpenOutside(const TContainer &container, const TClient &client,
+                       bool nonblock = false) const;
+    TError OpenInside(const TContainer &container) const;
+    bool MayBlockOutside(const TContainer &container) const;
 
     TError Remove(const TContainer &container);
 
     TError Rotate(const TContainer &container);
+    TError OpenRead(const TContainer &container, TFile &file) const;
     TError Read(const TContainer &container, std::string &text,
                 const std::string &range = "") const;
 };
@@ -106,6 +106,7 @@ void TTaskEnv::Abort(const TError &error) {
 
 static int ChildFn(void *arg) {
     TTaskEnv *task = static_cast<TTaskEnv*>(arg);
+    TTask::ForkedChild();
     task->StartChild();
     return EXIT_FAILURE;
 }
@@ -476,195 +477,214 @@ void TTaskEnv::StartChild() {
     Abort(error);
 }
 
-TError TTaskEnv::Start() {
-    TError error, error2;
+void TTaskEnv::StartParent() {
+    TError error;
 
-    CT->Task.Pid = 0;
-    CT->TaskVPid = 0;
-    CT->WaitTask.Pid = 0;
-    CT->SeizeTask.Pid = 0;
+    /* Switch from signafd back to normal signal delivery */
+    ResetBlockedSignals();
 
-    error = TUnixSocket::SocketPair(MasterSock, Sock);
-    if (error)
-        return error;
+    SetDieOnParentExit(SIGKILL);
 
-    // we want our child to have portod master as parent, so we
-    // are doing double fork here (fork + clone);
-    // we also need to know child pid so we are using pipe to send it back
+    SetProcessName("portod-CT" + std::to_string(CT->Id));
 
-    TTask task;
+    /* FIXME try to replace clone() with  unshare() */
+#if __has_feature(address_sanitizer) || defined(__SANITIZE_ADDRESS__)
+    char stack[8192*4];
+#else
+    char stack[8192];
+#endif
 
-    error = task.Fork();
-    if (error) {
-        Sock.Close();
-        L("Can't spawn child: {}", error);
-        return error;
+    (void)setsid();
+
+    // move to target cgroups
+    for (auto &cg : Cgroups) {
+        error = cg.Attach(GetPid());
+        if (error)
+            Abort(error);
     }
 
-    if (!task.Pid) {
-        TError error;
+    error = TPath("/proc/self/oom_score_adj").WriteAll(std::to_string(CT->OomScoreAdj));
+    if (error && CT->OomScoreAdj)
+        Abort(error);
 
-        /* Switch from signafd back to normal signal delivery */
-        ResetBlockedSignals();
+    if (setpriority(PRIO_PROCESS, 0, CT->SchedNice))
+        Abort(TError::System("setpriority"));
 
-        SetDieOnParentExit(SIGKILL);
+    struct sched_param param;
+    param.sched_priority = CT->SchedPrio;
+    if (sched_setscheduler(0, CT->SchedPolicy, &param))
+        Abort(TError::System("sched_setparm"));
 
-        SetProcessName("portod-CT" + std::to_string(CT->Id));
+    if (SetIoPrio(0, CT->IoPrio))
+        Abort(TError::System("ioprio"));
 
-        /* FIXME try to replace clone() with  unshare() */
-#if __has_feature(address_sanitizer) || defined(__SANITIZE_ADDRESS__)
-        char stack[8192*4];
-#else
-        char stack[8192];
-#endif
+    /* Default streams and redirections are outside */
+    error = CT->Stdin.OpenOutside(*CT, *Client, VForkSpawn);
+    if (error)
+        Abort(error);
 
-        (void)setsid();
+    error = CT->Stdout.OpenOutside(*CT, *Client, VForkSpawn);
+    if (error)
+        Abort(error);
 
-        // move to target cgroups
-        for (auto &cg : Cgroups) {
-            error = cg.Attach(GetPid());
-            if (error)
-                Abort(error);
-        }
+    error = CT->Stderr.OpenOutside(*CT, *Client, VForkSpawn);
+    if (error)
+        Abort(error);
 
-        error = TPath("/proc/self/oom_score_adj").WriteAll(std::to_string(CT->OomScoreAdj));
-        if (error && CT->OomScoreAdj)
-            Abort(error);
+    /* Enter namespaces */
 
-        if (setpriority(PRIO_PROCESS, 0, CT->SchedNice))
-            Abort(TError::System("setpriority"));
+    error = IpcFd.SetNs(CLONE_NEWIPC);
+    if (error)
+        Abort(error);
 
-        struct sched_param param;
-        param.sched_priority = CT->SchedPrio;
-        if (sched_setscheduler(0, CT->SchedPolicy, &param))
-            Abort(TError::System("sched_setparm"));
+    error = UtsFd.SetNs(CLONE_NEWUTS);
+    if (error)
+        Abort(error);
 
-        if (SetIoPrio(0, CT->IoPrio))
-            Abort(TError::System("ioprio"));
+    error = NetFd.SetNs(CLONE_NEWNET);
+    if (error)
+        Abort(error);
 
-        /* Default streams and redirections are outside */
-        error = CT->Stdin.OpenOutside(*CT, *Client);
-        if (error)
-            Abort(error);
+    error = PidFd.SetNs(CLONE_NEWPID);
+    if (error)
+        Abort(error);
 
-        error = CT->Stdout.OpenOutside(*CT, *Client);
-        if (error)
-            Abort(error);
+    error = MntFd.SetNs(CLONE_NEWNS);
+    if (error)
+        Abort(error);
 
-        error = CT->Stderr.OpenOutside(*CT, *Client);
-        if (error)
-            Abort(error);
+    error = RootFd.Chroot();
+    if (error)
+        Abort(error);
 
-        /* Enter namespaces */
+    error = CwdFd.Chdir();
+    if (error)
+        Abort(error);
 
-        error = IpcFd.SetNs(CLONE_NEWIPC);
-        if (error)
-            Abort(error);
+    if (TripleFork) {
+        /*
+         * Enter into pid-namespace. fork() hangs in libc if child pid
+         * collide with parent pid outside. vfork() has no such problem.
+         */
+        pid_t forkPid = vfork();
+        if (forkPid < 0)
+            Abort(TError::System("fork()"));
+
+        if (forkPid)
+            _exit(EXIT_SUCCESS);
 
-        error = UtsFd.SetNs(CLONE_NEWUTS);
+        error = TUnixSocket::SocketPair(MasterSock2, Sock2);
         if (error)
             Abort(error);
 
-        error = NetFd.SetNs(CLONE_NEWNET);
-        if (error)
-            Abort(error);
+        /* Report WPid */
+        ReportPid(GetTid());
+    }
 
-        error = PidFd.SetNs(CLONE_NEWPID);
-        if (error)
-            Abort(error);
+    int cloneFlags = SIGCHLD;
+    if (CT->Isolate)
+        cloneFlags |= CLONE_NEWPID | CLONE_NEWIPC;
 
-        error = MntFd.SetNs(CLONE_NEWNS);
-        if (error)
-            Abort(error);
+    if (NewMountNs)
+        cloneFlags |= CLONE_NEWNS;
 
-        error = RootFd.Chroot();
-        if (error)
-            Abort(error);
+    /* Create UTS namspace if hostname is changed or isolate=true */
+    if (CT->Isolate || CT->Hostname != "")
+        cloneFlags |= CLONE_NEWUTS;
 
-        error = CwdFd.Chdir();
-        if (error)
-            Abort(error);
+    pid_t clonePid = clone(ChildFn, stack + sizeof(stack), cloneFlags, this);
 
-        if (TripleFork) {
-            /*
-             * Enter into pid-namespace. fork() hangs in libc if child pid
-             * collide with parent pid outside. vfork() has no such problem.
-             */
-            pid_t forkPid = vfork();
-            if (forkPid < 0)
-                Abort(TError::System("fork()"));
+    if (clonePid < 0) {
+        TError error(errno == ENOMEM ?
+                     EError::ResourceNotAvailable :
+                     EError::Unknown, errno, "clone()");
+        Abort(error);
+    }
 
-            if (forkPid)
-                _exit(EXIT_SUCCESS);
+    if (!TripleFork)
+        _exit(EXIT_SUCCESS);
 
-            error = TUnixSocket::SocketPair(MasterSock2, Sock2);
-            if (error)
-                Abort(error);
+    /* close other side before reading */
+    Sock2.Close();
 
-            /* Report WPid */
-            ReportPid(GetTid());
-        }
+    pid_t appPid, appVPid;
+    error = MasterSock2.RecvPid(appPid, appVPid);
+    if (error)
+        Abort(error);
 
-        int cloneFlags = SIGCHLD;
-        if (CT->Isolate)
-            cloneFlags |= CLONE_NEWPID | CLONE_NEWIPC;
+    /* Forward VPid */
+    ReportPid(appPid);
 
-        if (NewMountNs)
-            cloneFlags |= CLONE_NEWNS;
+    /* Ack VPid */
+    error = MasterSock2.SendZero();
+    if (error)
+        Abort(error);
 
-        /* Create UTS namspace if hostname is changed or isolate=true */
-        if (CT->Isolate || CT->Hostname != "")
-            cloneFlags |= CLONE_NEWUTS;
+    MasterSock2.Close();
+
+    auto pid = std::to_string(clonePid);
+    const char * argv[] = {
+        "portoinit",
+        "--container",
+        CT->Name.c_str(),
+        "--wait",
+        pid.c_str(),
+        NULL,
+    };
+    auto envp = Env.Envp();
 
-        pid_t clonePid = clone(ChildFn, stack + sizeof(stack), cloneFlags, this);
+    error = PortoInitCapabilities.ApplyLimit();
+    if (error)
+        _exit(EXIT_FAILURE);
 
-        if (clonePid < 0) {
-            TError error(errno == ENOMEM ?
-                         EError::ResourceNotAvailable :
-                         EError::Unknown, errno, "clone()");
-            Abort(error);
-        }
+    TFile::CloseAll({PortoInit.Fd});
+    fexecve(PortoInit.Fd, (char *const *)argv, envp);
+    kill(clonePid, SIGKILL);
+    _exit(EXIT_FAILURE);
+}
 
-        if (!TripleFork)
-            _exit(EXIT_SUCCESS);
+static int ParentFn(void *arg) {
+    TTaskEnv *task = static_cast<TTaskEnv*>(arg);
+    task->StartParent();
+    return EXIT_FAILURE;
+}
 
-        /* close other side before reading */
-        Sock2.Close();
+TError TTaskEnv::Start() {
+    TError error, error2;
 
-        pid_t appPid, appVPid;
-        error = MasterSock2.RecvPid(appPid, appVPid);
-        if (error)
-            Abort(error);
+    CT->Task.Pid = 0;
+    CT->TaskVPid = 0;
+    CT->WaitTask.Pid = 0;
+    CT->SeizeTask.Pid = 0;
 
-        /* Forward VPid */
-        ReportPid(appPid);
+    error = TUnixSocket::SocketPair(MasterSock, Sock);
+    if (error)
+        return error;
 
-        /* Ack VPid */
-        error = MasterSock2.SendZero();
-        if (error)
-            Abort(error);
+    // we want our child to have portod master as parent, so we
+    // are doing double fork here (fork + clone);
+    // we also need to know child pid so we are using pipe to send it back
 
-        MasterSock2.Close();
+    TTask task;
 
-        auto pid = std::to_string(clonePid);
-        const char * argv[] = {
-            "portoinit",
-            "--container",
-            CT->Name.c_str(),
-            "--wait",
-            pid.c_str(),
-            NULL,
-        };
-        auto envp = Env.Envp();
+    if (VForkSpawn) {
+        error = task.VFork(ParentFn, this);
+        if (error) {
+            L("Can't vfork child: {}, fallback to fork", error);
+            VForkSpawn = false;
+        }
+    }
 
-        error = PortoInitCapabilities.ApplyLimit();
-        if (error)
-            _exit(EXIT_FAILURE);
+    if (!VForkSpawn) {
+        error = task.Fork();
+        if (!error && !task.Pid)
+            StartParent();
+    }
 
-        TFile::CloseAll({PortoInit.Fd});
-        fexecve(PortoInit.Fd, (char *const *)argv, envp);
-        kill(clonePid, SIGKILL);
-        _exit(EXIT_FAILURE);
+    if (error) {
+        Sock.Close();
+        L("Can't spawn child: {}", error);
+        return error;
     }
 
     Sock.Close();
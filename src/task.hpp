@@ -31,6 +31,7 @@ struct TTaskEnv {
     TEnv Env;
     bool TripleFork;
     bool QuadroFork;
+    bool VForkSpawn;
     std::vector<std::string> Autoconf;
     bool NewMountNs;
     std::vector<TCgroup> Cgroups;
@@ -44,6 +45,7 @@ struct TTaskEnv {
     TError OpenNamespaces(TContainer &ct);
 
     TError Start();
+    void StartParent();
     void StartChild();
 
     TError ConfigureChild();
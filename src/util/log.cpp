@@ -3,8 +3,18 @@
 #include "util/signal.hpp"
 #include "common.hpp"
 
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
+
 extern "C" {
 #include <unistd.h>
+#include <limits.h>
+#include <sys/uio.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/mman.h>
@@ -39,6 +49,444 @@ void InitStatistics() {
 }
 
 TFile LogFile(STDOUT_FILENO);
+TFile BinaryLogFile;
+
+__thread uint64_t LogContainerId;
+__thread uint64_t LogRequestId;
+
+/*
+ * Each thread appends lines into its own ring without locking, rings are
+ * drained by writer thread with writev. Line which does not fit is lost.
+ * Forked children and processes without writer write directly.
+ */
+
+constexpr uint64_t LOG_RING_SIZE = 128 << 10;
+constexpr uint64_t LOG_WRITER_PERIOD_MS = 100;
+
+struct TLogRing {
+    std::atomic<uint64_t> Head{0};
+    std::atomic<uint64_t> Tail{0};
+    std::atomic<bool> Dead{false};
+    char Data[LOG_RING_SIZE];
+};
+
+struct TLogRingRef {
+    std::shared_ptr<TLogRing> Ring;
+
+    ~TLogRingRef() {
+        if (Ring)
+            Ring->Dead = true;
+    }
+};
+
+static thread_local TLogRingRef ThreadLogRing;
+
+static std::mutex LogRingsMutex;
+static std::vector<std::shared_ptr<TLogRing>> LogRings;
+
+static std::mutex LogWriterMutex;   /* protects LogFile and ring tails */
+static std::condition_variable LogWriterCv;
+static std::thread LogWriterThread;
+static std::atomic<bool> LogWriterStop(false);
+static std::atomic<pid_t> LogWriterPid(0);
+
+static void LogWriteError(int err, uint64_t lines, uint64_t bytes) {
+    if (!Statistics)
+        return;
+    if (err != ENOSPC && err != EDQUOT && err != EROFS &&
+            err != EIO && err != EUCLEAN)
+        Statistics->Warns++;
+    Statistics->LogLinesLost += lines;
+    Statistics->LogBytesLost += bytes;
+}
+
+/*
+ * Binary log is sequence of records: varint size, kind, fields.
+ * Strings (formats, levels, thread names) are interned and defined by
+ * 'S' records before first use. 'H' record starts new string table.
+ */
+
+constexpr const char *BINARY_LOG_MAGIC = "PORTOLOG";
+constexpr uint64_t BINARY_LOG_VERSION = 1;
+
+enum {
+    LOG_RECORD_HEADER = 'H',
+    LOG_RECORD_STRING = 'S',
+    LOG_RECORD_ENTRY = 'E',
+};
+
+enum {
+    LOG_ARG_INT = 'i',
+    LOG_ARG_UINT = 'u',
+    LOG_ARG_DOUBLE = 'd',
+    LOG_ARG_STRING = 's',
+};
+
+static std::atomic<bool> LogBinary(false);
+
+static std::mutex LogStringsMutex;
+static std::unordered_map<std::string, uint64_t> LogStrings;
+static std::vector<const std::string *> LogStringsById;
+static std::string LogStringsPending;  /* definitions not written yet */
+
+static void PutVarint(std::string &buf, uint64_t val) {
+    while (val >= 0x80) {
+        buf.push_back((char)(val | 0x80));
+        val >>= 7;
+    }
+    buf.push_back((char)val);
+}
+
+static bool GetVarint(const std::string &buf, size_t &pos, uint64_t &val) {
+    val = 0;
+    for (int shift = 0; pos < buf.size() && shift < 64; shift += 7) {
+        uint8_t byte = buf[pos++];
+        val |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+static void PutRecord(std::string &buf, const std::string &body) {
+    PutVarint(buf, body.size());
+    buf += body;
+}
+
+void LogArgInt(std::string &buf, int64_t val) {
+    buf.push_back(LOG_ARG_INT);
+    PutVarint(buf, ((uint64_t)val << 1) ^ (uint64_t)(val >> 63));
+}
+
+void LogArgUint(std::string &buf, uint64_t val) {
+    buf.push_back(LOG_ARG_UINT);
+    PutVarint(buf, val);
+}
+
+void LogArgDouble(std::string &buf, double val) {
+    buf.push_back(LOG_ARG_DOUBLE);
+    buf.append((const char *)&val, sizeof(val));
+}
+
+void LogArgString(std::string &buf, const char *ptr, size_t len) {
+    buf.push_back(LOG_ARG_STRING);
+    PutVarint(buf, len);
+    buf.append(ptr, len);
+}
+
+/* Called under LogStringsMutex */
+static void DefineLogString(std::string &buf, uint64_t id, const std::string &str) {
+    std::string body;
+
+    body.push_back(LOG_RECORD_STRING);
+    PutVarint(body, id);
+    body += str;
+    PutRecord(buf, body);
+}
+
+static uint64_t InternLogString(const char *str) {
+    /* formats are mostly literals, cache them by address and verify text */
+    static thread_local std::unordered_map<const char *, std::pair<uint64_t, std::string>> cache;
+
+    auto it = cache.find(str);
+    if (it != cache.end() && it->second.second == str)
+        return it->second.first;
+
+    std::lock_guard<std::mutex> lock(LogStringsMutex);
+    auto ins = LogStrings.emplace(str, LogStringsById.size() + 1);
+    if (ins.second) {
+        LogStringsById.push_back(&ins.first->first);
+        DefineLogString(LogStringsPending, ins.first->second, str);
+    }
+    cache[str] = std::make_pair(ins.first->second, std::string(str));
+
+    return ins.first->second;
+}
+
+static uint64_t CountLogRecords(const struct iovec *iov, int iovcnt, bool binary) {
+    uint64_t records = 0, skip = 0, size = 0;
+    int shift = 0;
+
+    for (int i = 0; i < iovcnt; i++) {
+        const char *ptr = (const char *)iov[i].iov_base;
+        const char *end = ptr + iov[i].iov_len;
+
+        if (!binary) {
+            records += std::count(ptr, end, '\n');
+            continue;
+        }
+
+        while (ptr < end) {
+            if (skip) {
+                uint64_t len = std::min(skip, (uint64_t)(end - ptr));
+                ptr += len;
+                skip -= len;
+                continue;
+            }
+            uint8_t byte = *ptr++;
+            size |= (uint64_t)(byte & 0x7f) << shift;
+            shift += 7;
+            if (!(byte & 0x80)) {
+                records++;
+                skip = size;
+                size = 0;
+                shift = 0;
+            }
+        }
+    }
+
+    return records;
+}
+
+static void LogWriteAll(const TFile &file, struct iovec *iov, int iovcnt) {
+    while (iovcnt && file) {
+        ssize_t ret = writev(file.Fd, iov, iovcnt);
+        if (ret < 0 && errno == EINTR)
+            continue;
+        if (ret <= 0) {
+            int err = ret ? errno : EIO;
+            uint64_t bytes = 0;
+
+            for (int i = 0; i < iovcnt; i++)
+                bytes += iov[i].iov_len;
+            LogWriteError(err, CountLogRecords(iov, iovcnt, LogBinary), bytes);
+            return;
+        }
+        while (iovcnt && (size_t)ret >= iov->iov_len) {
+            ret -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt) {
+            iov->iov_base = (char *)iov->iov_base + ret;
+            iov->iov_len -= ret;
+        }
+    }
+}
+
+/* Called under LogWriterMutex, returns true if something was written */
+static bool DrainLogRings() {
+    std::vector<std::shared_ptr<TLogRing>> rings;
+    std::vector<uint64_t> heads;
+    struct iovec iov[IOV_MAX];
+    std::string strings;
+    int iovcnt = 1;
+
+    std::unique_lock<std::mutex> lock(LogRingsMutex);
+    rings = LogRings;
+    lock.unlock();
+
+    for (auto &ring: rings) {
+        uint64_t head = ring->Head.load(std::memory_order_acquire);
+        uint64_t tail = ring->Tail.load(std::memory_order_relaxed);
+
+        heads.push_back(head);
+
+        if (head == tail)
+            continue;
+
+        if (iovcnt + 2 > IOV_MAX) {
+            heads.back() = tail;
+            continue;
+        }
+
+        uint64_t off = tail % LOG_RING_SIZE;
+        uint64_t len = std::min(head - tail, LOG_RING_SIZE - off);
+
+        iov[iovcnt].iov_base = ring->Data + off;
+        iov[iovcnt++].iov_len = len;
+        if (len < head - tail) {
+            iov[iovcnt].iov_base = ring->Data;
+            iov[iovcnt++].iov_len = head - tail - len;
+        }
+    }
+
+    /* string definitions must precede records which refer them */
+    if (LogBinary) {
+        std::lock_guard<std::mutex> lock(LogStringsMutex);
+        strings.swap(LogStringsPending);
+    }
+    iov[0].iov_base = (void *)strings.data();
+    iov[0].iov_len = strings.size();
+
+    if (iovcnt > 1 || strings.size())
+        LogWriteAll(LogBinary ? BinaryLogFile : LogFile, iov, iovcnt);
+
+    bool dead = false;
+    for (size_t i = 0; i < rings.size(); i++) {
+        rings[i]->Tail.store(heads[i], std::memory_order_release);
+        dead |= rings[i]->Dead && rings[i]->Head == heads[i];
+    }
+
+    if (dead) {
+        lock.lock();
+        for (auto it = LogRings.begin(); it != LogRings.end(); ) {
+            if ((*it)->Dead && (*it)->Head == (*it)->Tail)
+                it = LogRings.erase(it);
+            else
+                it++;
+        }
+    }
+
+    return iovcnt > 1;
+}
+
+static void LogWriter() {
+    SetProcessName("portod-LOG");
+
+    std::unique_lock<std::mutex> lock(LogWriterMutex);
+    while (!LogWriterStop) {
+        if (!DrainLogRings())
+            LogWriterCv.wait_for(lock, std::chrono::milliseconds(LOG_WRITER_PERIOD_MS));
+    }
+    DrainLogRings();
+}
+
+void StartLogWriter() {
+    if (LogWriterThread.joinable())
+        return;
+    LogWriterStop = false;
+    LogWriterThread = std::thread(LogWriter);
+    LogWriterPid = GetPid();
+}
+
+void StopLogWriter() {
+    if (!LogWriterThread.joinable())
+        return;
+    LogWriterPid = 0;
+    LogWriterStop = true;
+    LogWriterCv.notify_all();
+    LogWriterThread.join();
+}
+
+/* Write out everything and continue synchronously, for crash paths */
+void FlushLog() {
+    if (LogWriterPid != GetPid())
+        return;
+    LogWriterPid = 0;
+
+    std::unique_lock<std::mutex> lock(LogWriterMutex, std::defer_lock);
+    for (int i = 0; i < 100 && !lock.try_lock(); i++)
+        usleep(10000);
+    if (lock.owns_lock())
+        DrainLogRings();
+}
+
+static bool QueueLog(const std::string &msg) {
+    auto &ring = ThreadLogRing.Ring;
+
+    if (!ring) {
+        ring = std::shared_ptr<TLogRing>(new TLogRing);
+        std::lock_guard<std::mutex> lock(LogRingsMutex);
+        LogRings.push_back(ring);
+    }
+
+    uint64_t head = ring->Head.load(std::memory_order_relaxed);
+    uint64_t tail = ring->Tail.load(std::memory_order_acquire);
+    uint64_t off = head % LOG_RING_SIZE;
+    uint64_t len = std::min(msg.size(), LOG_RING_SIZE - off);
+
+    if (msg.size() > LOG_RING_SIZE - (head - tail))
+        return false;
+
+    memcpy(ring->Data + off, msg.data(), len);
+    memcpy(ring->Data, msg.data() + len, msg.size() - len);
+    ring->Head.store(head + msg.size(), std::memory_order_release);
+
+    /* wake writer when ring becomes non-empty or half full */
+    if (head == tail || (head - tail < LOG_RING_SIZE / 2 &&
+                         head - tail + msg.size() >= LOG_RING_SIZE / 2))
+        LogWriterCv.notify_one();
+
+    return true;
+}
+
+/* Binary log is written only by log writer thread in portod */
+bool BinaryLogActive() {
+    return LogBinary && LogWriterPid && LogWriterPid == GetPid();
+}
+
+void OpenBinaryLog(const TPath &path) {
+    struct stat st;
+    std::string buf, body;
+    int fd;
+
+    fd = open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC |
+                            O_NOFOLLOW | O_NOCTTY, 0644);
+    if (fd < 0) {
+        L_ERR("Cannot open binary log {}: {}", path, TError::System("open"));
+        return;
+    }
+    if (!fstat(fd, &st) && (st.st_mode & 0777) != 0644)
+        fchmod(fd, 0644);
+    if (fd < 3)
+        fd = fcntl(fd, F_DUPFD_CLOEXEC, 3);
+
+    std::lock_guard<std::mutex> writer_lock(LogWriterMutex);
+    std::lock_guard<std::mutex> strings_lock(LogStringsMutex);
+
+    /* new file gets header and all known strings */
+    body = BINARY_LOG_MAGIC;
+    body.insert(0, 1, LOG_RECORD_HEADER);
+    PutVarint(body, BINARY_LOG_VERSION);
+    PutVarint(body, GetPid());
+    PutRecord(buf, body);
+    for (uint64_t id = 1; id <= LogStringsById.size(); id++)
+        DefineLogString(buf, id, *LogStringsById[id - 1]);
+    LogStringsPending.clear();
+
+    BinaryLogFile.Close();
+    BinaryLogFile.SetFd = fd;
+    if (BinaryLogFile.WriteAll(buf))
+        LogWriteError(errno, 1, buf.size());
+    LogBinary = true;
+}
+
+void WriteBinaryLog(const char *prefix, const char *fmt,
+                    const std::string &args, int argc) {
+    std::string body, record;
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    body.push_back(LOG_RECORD_ENTRY);
+    PutVarint(body, (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+    PutVarint(body, GetTid());
+    PutVarint(body, InternLogString(GetTaskName().c_str()));
+    PutVarint(body, InternLogString(prefix));
+    PutVarint(body, LogContainerId);
+    PutVarint(body, LogRequestId);
+    PutVarint(body, InternLogString(fmt));
+    PutVarint(body, argc);
+    body += args;
+    PutRecord(record, body);
+
+    if (Statistics) {
+        Statistics->LogLines++;
+        Statistics->LogBytes += record.size();
+    }
+
+    if (!QueueLog(record) && Statistics) {
+        Statistics->LogLinesLost++;
+        Statistics->LogBytesLost += record.size();
+    }
+}
+
+static const char *LogTime() {
+    static __thread time_t cachedTime;
+    static __thread char cachedStr[32];
+    time_t now = time(nullptr);
+
+    if (now != cachedTime || !cachedStr[0]) {
+        struct tm tm;
+
+        LocalTime(&now, tm);
+        strftime(cachedStr, sizeof(cachedStr), "%F %T", &tm);
+        cachedTime = now;
+    }
+
+    return cachedStr;
+}
 
 void OpenLog(const TPath &path) {
     int fd;
@@ -57,6 +505,7 @@ void OpenLog(const TPath &path) {
         fd = fcntl(fd, F_DUPFD_CLOEXEC, 3);
 
     if (fd >= 0) {
+        std::lock_guard<std::mutex> lock(LogWriterMutex);
         if (LogFile.Fd != STDOUT_FILENO)
             LogFile.Close();
         LogFile.SetFd = fd;
@@ -70,27 +519,255 @@ void OpenLog(const TPath &path) {
 }
 
 void WriteLog(const char *prefix, const std::string &log_msg) {
+    if (BinaryLogActive()) {
+        std::string arg;
+        LogArgString(arg, log_msg.data(), log_msg.size());
+        WriteBinaryLog(prefix, "{}", arg, 1);
+        return;
+    }
+
     std::string msg = fmt::format("{} {}[{}]: {} {}\n",
-            FormatTime(time(nullptr)), GetTaskName(), GetTid(), prefix, log_msg);
+            LogTime(), GetTaskName(), GetTid(), prefix, log_msg);
 
     if (Statistics) {
         Statistics->LogLines++;
         Statistics->LogBytes += msg.size();
     }
 
+    if (LogWriterPid && LogWriterPid == GetPid()) {
+        if (!QueueLog(msg) && Statistics) {
+            Statistics->LogLinesLost++;
+            Statistics->LogBytesLost += msg.size();
+        }
+        return;
+    }
+
     if (!LogFile)
         return;
 
     TError error = LogFile.WriteAll(msg);
-    if (error && Statistics) {
-        if (error.Errno != ENOSPC &&
-                error.Errno != EDQUOT &&
-                error.Errno != EROFS &&
-                error.Errno != EIO &&
-                error.Errno != EUCLEAN)
-            Statistics->Warns++;
-        Statistics->LogLinesLost++;
-        Statistics->LogBytesLost += msg.size();
+    if (error)
+        LogWriteError(error.Errno, 1, msg.size());
+}
+
+struct TLogArg {
+    char Type;
+    int64_t Int;
+    uint64_t Uint;
+    double Double;
+    std::string String;
+};
+
+static std::string RenderLogArg(const std::string &spec, const TLogArg &arg) {
+    if (spec.empty()) {
+        switch (arg.Type) {
+        case LOG_ARG_INT:
+            return std::to_string(arg.Int);
+        case LOG_ARG_UINT:
+            return std::to_string(arg.Uint);
+        case LOG_ARG_STRING:
+            return arg.String;
+        }
+    }
+
+    std::string fmt = "{" + spec + "}";
+    switch (arg.Type) {
+    case LOG_ARG_INT:
+        return fmt::format(fmt, arg.Int);
+    case LOG_ARG_UINT:
+        return fmt::format(fmt, arg.Uint);
+    case LOG_ARG_DOUBLE:
+        return fmt::format(fmt, arg.Double);
+    default:
+        return fmt::format(fmt, arg.String);
+    }
+}
+
+/* Subset of fmt syntax: {}, {N}, {:spec}, {N:spec}, {{ and }} */
+static std::string RenderLogFormat(const std::string &fmt, const std::vector<TLogArg> &args) {
+    std::string text;
+    uint64_t next = 0;
+
+    for (size_t i = 0; i < fmt.size(); i++) {
+        char c = fmt[i];
+
+        if ((c == '{' || c == '}') && i + 1 < fmt.size() && fmt[i + 1] == c) {
+            text.push_back(c);
+            i++;
+            continue;
+        }
+
+        auto end = fmt.find('}', i);
+        if (c != '{' || end == std::string::npos) {
+            text.push_back(c);
+            continue;
+        }
+
+        std::string field = fmt.substr(i + 1, end - i - 1);
+        auto colon = field.find(':');
+        std::string index = field.substr(0, colon);
+        std::string spec = colon == std::string::npos ? "" : field.substr(colon);
+        uint64_t n = next++;
+
+        if ((index.size() && StringToUint64(index, n)) || n >= args.size())
+            text += fmt.substr(i, end - i + 1);
+        else
+            text += RenderLogArg(spec, args[n]);
+        i = end;
+    }
+
+    return text;
+}
+
+TError TBinaryLogReader::Open(const TPath &path) {
+    Close();
+    File = fopen(path.c_str(), "re");
+    if (!File)
+        return TError::System("fopen " + path.ToString());
+    return OK;
+}
+
+void TBinaryLogReader::Close() {
+    if (File)
+        fclose(File);
+    File = nullptr;
+    Strings.clear();
+}
+
+TError TBinaryLogReader::ReadRecord(bool &eof) {
+    uint64_t size = 0;
+    int shift = 0, byte;
+
+    eof = false;
+    do {
+        byte = getc_unlocked(File);
+        if (byte == EOF) {
+            if (shift)
+                return TError("Truncated binary log record");
+            eof = true;
+            return OK;
+        }
+        size |= (uint64_t)(byte & 0x7f) << shift;
+        shift += 7;
+        if (shift > 63)
+            return TError("Corrupted binary log record size");
+    } while (byte & 0x80);
+
+    Record.resize(size);
+    if (size && fread(&Record[0], 1, size, File) != size) {
+        if (ferror(File))
+            return TError::System("fread");
+        /* last record is being written */
+        eof = true;
+    }
+
+    return OK;
+}
+
+TError TBinaryLogReader::GetString(uint64_t id, std::string &str) const {
+    if (!id || id > Strings.size())
+        return TError("Unknown string {} in binary log", id);
+    str = Strings[id - 1];
+    return OK;
+}
+
+TError TBinaryLogReader::Next(TBinaryLogEntry &entry, bool &eof) {
+    std::vector<TLogArg> args;
+    std::string fmt;
+    TError error;
+
+    while (true) {
+        uint64_t id, val, argc, fmtId, levelId, taskId;
+        size_t pos = 1;
+
+        error = ReadRecord(eof);
+        if (error || eof)
+            return error;
+        if (Record.empty())
+            continue;
+
+        switch (Record[0]) {
+        case LOG_RECORD_HEADER:
+            if (Record.compare(1, strlen(BINARY_LOG_MAGIC), BINARY_LOG_MAGIC))
+                return TError("Wrong binary log magic");
+            Strings.clear();
+            continue;
+        case LOG_RECORD_STRING:
+            if (!GetVarint(Record, pos, id) || !id)
+                return TError("Corrupted binary log string");
+            if (Strings.size() < id)
+                Strings.resize(id);
+            Strings[id - 1] = Record.substr(pos);
+            continue;
+        case LOG_RECORD_ENTRY:
+            break;
+        default:
+            continue;
+        }
+
+        if (!GetVarint(Record, pos, entry.Time) ||
+                !GetVarint(Record, pos, val) ||
+                !GetVarint(Record, pos, taskId) ||
+                !GetVarint(Record, pos, levelId) ||
+                !GetVarint(Record, pos, entry.ContainerId) ||
+                !GetVarint(Record, pos, entry.RequestId) ||
+                !GetVarint(Record, pos, fmtId) ||
+                !GetVarint(Record, pos, argc))
+            return TError("Corrupted binary log entry");
+        entry.Tid = val;
+
+        /* filter before decoding arguments */
+        if ((ContainerId && entry.ContainerId != ContainerId) ||
+                (RequestId && entry.RequestId != RequestId) ||
+                entry.Time < Since)
+            continue;
+
+        error = GetString(levelId, entry.Level);
+        if (error)
+            return error;
+        if (Level.size() && StringTrim(entry.Level) != Level)
+            continue;
+
+        error = GetString(taskId, entry.Task);
+        if (!error)
+            error = GetString(fmtId, fmt);
+        if (error)
+            return error;
+
+        args.resize(argc);
+        for (auto &arg: args) {
+            if (pos >= Record.size())
+                return TError("Corrupted binary log argument");
+            arg.Type = Record[pos++];
+            switch (arg.Type) {
+            case LOG_ARG_INT:
+                if (!GetVarint(Record, pos, val))
+                    return TError("Corrupted binary log argument");
+                arg.Int = (int64_t)(val >> 1) ^ -(int64_t)(val & 1);
+                break;
+            case LOG_ARG_UINT:
+                if (!GetVarint(Record, pos, arg.Uint))
+                    return TError("Corrupted binary log argument");
+                break;
+            case LOG_ARG_DOUBLE:
+                if (pos + sizeof(arg.Double) > Record.size())
+                    return TError("Corrupted binary log argument");
+                memcpy(&arg.Double, &Record[pos], sizeof(arg.Double));
+                pos += sizeof(arg.Double);
+                break;
+            case LOG_ARG_STRING:
+                if (!GetVarint(Record, pos, val) || pos + val > Record.size())
+                    return TError("Corrupted binary log argument");
+                arg.String = Record.substr(pos, val);
+                pos += val;
+                break;
+            default:
+                return TError("Unknown binary log argument type {}", arg.Type);
+            }
+        }
+
+        entry.Text = RenderLogFormat(fmt, args);
+        return OK;
     }
 }
 
@@ -101,6 +778,7 @@ void porto_assert(const char *msg, const char *file, size_t line) {
 
 void FatalError(const std::string &text, TError &error) {
     L_ERR("{}: {}", text, error);
+    FlushLog();
     _exit(EXIT_FAILURE);
 }
 
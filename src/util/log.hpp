@@ -2,6 +2,8 @@
 
 #include <atomic>
 #include <string>
+#include <vector>
+#include <type_traits>
 #include "util/path.hpp"
 #include "fmt/format.h"
 
@@ -10,8 +12,103 @@ extern bool Verbose;
 extern bool Debug;
 extern TFile LogFile;
 
+/* Context for binary log records */
+extern __thread uint64_t LogContainerId;
+extern __thread uint64_t LogRequestId;
+
 void OpenLog(const TPath &path);
 void WriteLog(const char *prefix, const std::string &log_msg);
+void StartLogWriter();
+void StopLogWriter();
+void FlushLog();
+
+void OpenBinaryLog(const TPath &path);
+bool BinaryLogActive();
+void WriteBinaryLog(const char *prefix, const char *fmt,
+                    const std::string &args, int argc);
+
+void LogArgInt(std::string &buf, int64_t val);
+void LogArgUint(std::string &buf, uint64_t val);
+void LogArgDouble(std::string &buf, double val);
+void LogArgString(std::string &buf, const char *ptr, size_t len);
+
+template <typename T>
+using TLogAsInt = std::integral_constant<bool, std::is_integral<T>::value &&
+    !std::is_same<T, bool>::value && !std::is_same<T, char>::value &&
+    !std::is_same<T, signed char>::value && !std::is_same<T, unsigned char>::value>;
+
+template <typename T>
+inline typename std::enable_if<TLogAsInt<T>::value && std::is_signed<T>::value>::type
+LogArg(std::string &buf, const T &val) {
+    LogArgInt(buf, val);
+}
+
+template <typename T>
+inline typename std::enable_if<TLogAsInt<T>::value && std::is_unsigned<T>::value>::type
+LogArg(std::string &buf, const T &val) {
+    LogArgUint(buf, val);
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_floating_point<T>::value>::type
+LogArg(std::string &buf, const T &val) {
+    LogArgDouble(buf, val);
+}
+
+template <typename T>
+inline typename std::enable_if<!TLogAsInt<T>::value && !std::is_floating_point<T>::value>::type
+LogArg(std::string &buf, const T &val) {
+    std::string str = fmt::format("{}", val);
+    LogArgString(buf, str.data(), str.size());
+}
+
+inline void LogArg(std::string &buf, const std::string &val) {
+    LogArgString(buf, val.data(), val.size());
+}
+
+/* Binary log stores format and arguments, text is rendered by reader */
+template <typename... Args>
+inline void LogFormat(const char *prefix, const char *fmt, const Args&... args) {
+    if (BinaryLogActive()) {
+        std::string buf;
+        int unused[] = { 0, (LogArg(buf, args), 0)... };
+        (void)unused;
+        WriteBinaryLog(prefix, fmt, buf, sizeof...(args));
+    } else
+        WriteLog(prefix, fmt::format(fmt, args...));
+}
+
+struct TBinaryLogEntry {
+    uint64_t Time;          /* usec */
+    pid_t Tid;
+    std::string Task;
+    std::string Level;
+    uint64_t ContainerId;
+    uint64_t RequestId;
+    std::string Text;
+};
+
+class TBinaryLogReader {
+    FILE *File = nullptr;
+    std::vector<std::string> Strings;
+    std::string Record;
+
+    TError ReadRecord(bool &eof);
+    TError GetString(uint64_t id, std::string &str) const;
+
+public:
+    /* Filters, zero or empty matches everything */
+    uint64_t ContainerId = 0;
+    uint64_t RequestId = 0;
+    uint64_t Since = 0;
+    std::string Level;
+
+    ~TBinaryLogReader() { Close(); }
+
+    TError Open(const TPath &path);
+    void Close();
+    TError Next(TBinaryLogEntry &entry, bool &eof);
+};
 void Stacktrace();
 
 struct TStatistics {
@@ -61,6 +158,18 @@ struct TStatistics {
     std::atomic<uint64_t> Taints;
     std::atomic<uint64_t> ContainersTainted;
     std::atomic<uint64_t> LongestRoRequest;
+    std::atomic<uint64_t> NetworkSyncLongest;
+    std::atomic<uint64_t> NetworkWatchdogOverruns;
+    std::atomic<uint64_t> RemoveQueued;
+    std::atomic<uint64_t> RemoveReclaimed;
+    std::atomic<uint64_t> VolumesPooled;
+    std::atomic<uint64_t> VolumePoolHits;
+    std::atomic<uint64_t> HelpersStarted;
+    std::atomic<uint64_t> HelpersCanceled;
+    std::atomic<uint64_t> HelpersCpuUsage;
+    std::atomic<uint64_t> HelpersReadBytes;
+    std::atomic<uint64_t> HelpersWriteBytes;
+    std::atomic<uint64_t> PidfdExits;
 
     /* --- add new fields at the end --- */
 };
@@ -79,32 +188,35 @@ static inline void ResetStatistics() {
     Statistics->RequestsQueued = 0;
     Statistics->NetworksCount = 0;
     Statistics->LongestRoRequest = 0;
+    Statistics->NetworkSyncLongest = 0;
+    Statistics->RemoveQueued = 0;
+    Statistics->VolumesPooled = 0;
 }
 
 template <typename... Args> inline void L_DBG(const char* fmt, const Args&... args) {
     if (Debug)
-        WriteLog("DBG", fmt::format(fmt, args...));
+        LogFormat("DBG", fmt, args...);
 }
 
 template <typename... Args> inline void L_VERBOSE(const char* fmt, const Args&... args) {
     if (Verbose)
-        WriteLog("   ", fmt::format(fmt, args...));
+        LogFormat("   ", fmt, args...);
 }
 
 template <typename... Args> inline void L(const char* fmt, const Args&... args) {
-    WriteLog("   ", fmt::format(fmt, args...));
+    LogFormat("   ", fmt, args...);
 }
 
 template <typename... Args> inline void L_WRN(const char* fmt, const Args&... args) {
     if (Statistics)
         Statistics->Warns++;
-    WriteLog("WRN", fmt::format(fmt, args...));
+    LogFormat("WRN", fmt, args...);
 }
 
 template <typename... Args> inline void L_ERR(const char* fmt, const Args&... args) {
     if (Statistics)
         Statistics->Errors++;
-    WriteLog("ERR", fmt::format(fmt, args...));
+    LogFormat("ERR", fmt, args...);
     if (Verbose)
         Stacktrace();
 }
@@ -116,48 +228,48 @@ inline void L_TAINT(const std::string &text) {
 }
 
 template <typename... Args> inline void L_EVT(const char* fmt, const Args&... args) {
-    WriteLog("EVT", fmt::format(fmt, args...));
+    LogFormat("EVT", fmt, args...);
 }
 
 template <typename... Args> inline void L_ACT(const char* fmt, const Args&... args) {
-    WriteLog("ACT", fmt::format(fmt, args...));
+    LogFormat("ACT", fmt, args...);
 }
 
 template <typename... Args> inline void L_CG(const char* fmt, const Args&... args) {
-    WriteLog("CG ", fmt::format(fmt, args...));
+    LogFormat("CG ", fmt, args...);
 }
 
 template <typename... Args> inline void L_REQ(const char* fmt, const Args&... args) {
-    WriteLog("REQ", fmt::format(fmt, args...));
+    LogFormat("REQ", fmt, args...);
 }
 
 template <typename... Args> inline void L_RSP(const char* fmt, const Args&... args) {
-    WriteLog("RSP", fmt::format(fmt, args...));
+    LogFormat("RSP", fmt, args...);
 }
 
 template <typename... Args> inline void L_SYS(const char* fmt, const Args&... args) {
-    WriteLog("SYS", fmt::format(fmt, args...));
+    LogFormat("SYS", fmt, args...);
 }
 
 template <typename... Args> inline void L_STK(const char* fmt, const Args&... args) {
-    WriteLog("STK", fmt::format(fmt, args...));
+    LogFormat("STK", fmt, args...);
 }
 
 template <typename... Args> inline void L_NET(const char* fmt, const Args&... args) {
-    WriteLog("NET", fmt::format(fmt, args...));
+    LogFormat("NET", fmt, args...);
 }
 
 template <typename... Args> inline void L_NET_VERBOSE(const char* fmt, const Args&... args) {
     if (Verbose)
-        WriteLog("NET", fmt::format(fmt, args...));
+        LogFormat("NET", fmt, args...);
 }
 
 template <typename... Args> inline void L_NL(const char* fmt, const Args&... args) {
-    WriteLog("NL ", fmt::format(fmt, args...));
+    LogFormat("NL ", fmt, args...);
 }
 
 template <typename... Args> inline void L_CORE(const char* fmt, const Args&... args) {
-    WriteLog("CORE", fmt::format(fmt, args...));
+    LogFormat("CORE", fmt, args...);
 }
 
 void porto_assert(const char *msg, const char *file, size_t line);
@@ -36,6 +36,7 @@
  */
 
 #include "md5.hpp"
+#include "xxhash.hpp"
 
 /* Any 32-bit or wider unsigned integer data type will do */
 typedef unsigned int MD5_u32plus;
@@ -294,24 +295,43 @@ static void MD5_Final(unsigned char *result, MD5_CTX *ctx)
     memset(ctx, 0, sizeof(*ctx));
 }
 
-TError Md5Sum(TFile &file, std::string &sum) {
+TError Md5Sum(TFile &file, std::string &sum, std::string *xxh64) {
     MD5_CTX ctx;
+    TXxh64 xxh;
     unsigned char bin[16];
     std::string buf;
     TError error;
 
     MD5_Init(&ctx);
     while (1) {
+        buf.resize(1 << 20);
         error = file.Read(buf);
         if (error)
             return error;
         if (!buf.size())
             break;
         MD5_Update(&ctx, buf.c_str(), buf.size());
+        if (xxh64)
+            xxh.Update(buf.c_str(), buf.size());
     }
     MD5_Final(bin, &ctx);
     sum = "";
     for (int i = 0; i < 16; ++i)
         sum += fmt::format("{:02x}", bin[i]);
+    if (xxh64)
+        *xxh64 = fmt::format("{:016x}", xxh.Digest());
     return OK;
 }
+
+std::string Md5Sum(const std::string &data) {
+    MD5_CTX ctx;
+    unsigned char bin[16];
+    std::string sum;
+
+    MD5_Init(&ctx);
+    MD5_Update(&ctx, data.c_str(), data.size());
+    MD5_Final(bin, &ctx);
+    for (int i = 0; i < 16; ++i)
+        sum += fmt::format("{:02x}", bin[i]);
+    return sum;
+}
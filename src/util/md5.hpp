@@ -2,4 +2,8 @@
 
 #include "util/path.hpp"
 
-TError Md5Sum(TFile &file, std::string &sum);
+/* Optionally computes xxh64 in the same pass */
+TError Md5Sum(TFile &file, std::string &sum, std::string *xxh64 = nullptr);
+
+/* Digest of data in memory */
+std::string Md5Sum(const std::string &data);
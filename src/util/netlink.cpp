@@ -16,6 +16,7 @@ extern "C" {
 #include <linux/if_ether.h>
 #include <linux/if_addrlabel.h>
 #include <linux/pkt_sched.h>
+#include <linux/gen_stats.h>
 #include <netinet/ether.h>
 #include <netlink/route/class.h>
 #include <netlink/route/classifier.h>
@@ -229,6 +230,196 @@ free_msg:
     return error;
 }
 
+TError TNl::DumpClassStat(int index,
+        const std::function<void(uint32_t handle, const TNlTcStat &stat)> &fn) const {
+    struct tcmsg tchdr = {};
+    struct nl_cb *cb;
+    int ret;
+
+    tchdr.tcm_family = AF_UNSPEC;
+    tchdr.tcm_ifindex = index;
+
+    ret = nl_send_simple(Sock, RTM_GETTCLASS, NLM_F_DUMP, &tchdr, sizeof(tchdr));
+    if (ret < 0)
+        return Error(ret, "Cannot request class dump");
+
+    cb = nl_cb_clone(nl_socket_get_cb(Sock));
+    if (!cb)
+        return TError("Cannot allocate netlink callback");
+
+    nl_cb_set(cb, NL_CB_VALID, NL_CB_CUSTOM, [](struct nl_msg *msg, void *arg) -> int {
+        auto &fn = *(const std::function<void(uint32_t, const TNlTcStat &)> *)arg;
+        struct nlmsghdr *hdr = nlmsg_hdr(msg);
+        struct nlattr *tb[TCA_MAX + 1], *tbs[TCA_STATS_MAX + 1];
+        struct tcmsg *tcm = (struct tcmsg *)nlmsg_data(hdr);
+        TNlTcStat stat;
+
+        if (hdr->nlmsg_type != RTM_NEWTCLASS ||
+                nlmsg_parse(hdr, sizeof(*tcm), tb, TCA_MAX, nullptr) < 0)
+            return NL_SKIP;
+
+        if (tb[TCA_STATS2] &&
+                !nla_parse_nested(tbs, TCA_STATS_MAX, tb[TCA_STATS2], nullptr)) {
+            if (tbs[TCA_STATS_BASIC]) {
+                struct gnet_stats_basic basic = {};
+                memcpy(&basic, nla_data(tbs[TCA_STATS_BASIC]),
+                       std::min((size_t)nla_len(tbs[TCA_STATS_BASIC]), sizeof(basic)));
+                stat.Bytes = basic.bytes;
+                stat.Packets = basic.packets;
+            }
+            if (tbs[TCA_STATS_QUEUE]) {
+                struct gnet_stats_queue queue = {};
+                memcpy(&queue, nla_data(tbs[TCA_STATS_QUEUE]),
+                       std::min((size_t)nla_len(tbs[TCA_STATS_QUEUE]), sizeof(queue)));
+                stat.Drops = queue.drops;
+                stat.Overlimits = queue.overlimits;
+            }
+        } else if (tb[TCA_STATS]) {
+            struct tc_stats st = {};
+            memcpy(&st, nla_data(tb[TCA_STATS]),
+                   std::min((size_t)nla_len(tb[TCA_STATS]), sizeof(st)));
+            stat.Bytes = st.bytes;
+            stat.Packets = st.packets;
+            stat.Drops = st.drops;
+            stat.Overlimits = st.overlimits;
+        }
+
+        fn(tcm->tcm_handle, stat);
+
+        return NL_OK;
+    }, (void *)&fn);
+
+    ret = nl_recvmsgs(Sock, cb);
+    nl_cb_put(cb);
+
+    if (ret < 0)
+        return Error(ret, "Cannot dump classes");
+
+    return OK;
+}
+
+TError TNl::SubscribeEvents(const std::vector<int> &groups) {
+    int ret;
+
+    nl_socket_disable_seq_check(Sock);
+
+    for (auto group: groups) {
+        ret = nl_socket_add_membership(Sock, group);
+        if (ret < 0)
+            return Error(ret, "Cannot join netlink group " + std::to_string(group));
+    }
+
+    ret = nl_socket_set_buffer_size(Sock, 1 << 20, 0);
+    if (ret < 0)
+        return Error(ret, "Cannot set netlink buffer size");
+
+    ret = nl_socket_set_nonblocking(Sock);
+    if (ret < 0)
+        return Error(ret, "Cannot set netlink socket nonblocking");
+
+    return OK;
+}
+
+TError TNl::RecvEvents(const std::function<void(struct nl_msg *msg)> &fn) {
+    struct nl_cb *cb;
+    int ret;
+
+    cb = nl_cb_clone(nl_socket_get_cb(Sock));
+    if (!cb)
+        return TError("Cannot allocate netlink callback");
+
+    nl_cb_set(cb, NL_CB_VALID, NL_CB_CUSTOM, [](struct nl_msg *msg, void *arg) -> int {
+        (*(const std::function<void(struct nl_msg *)> *)arg)(msg);
+        return NL_OK;
+    }, (void *)&fn);
+
+    do
+        ret = nl_recvmsgs_report(Sock, cb);
+    while (ret > 0);
+
+    nl_cb_put(cb);
+
+    /* Overflow is reported as -NLE_NOMEM, some events are lost */
+    if (ret < 0 && ret != -NLE_AGAIN)
+        return Error(ret, "Cannot receive netlink events");
+
+    return OK;
+}
+
+TNlBatch::~TNlBatch() {
+    for (auto msg: Msgs)
+        nlmsg_free(msg);
+}
+
+TError TNlBatch::Commit(std::vector<TError> &errors) {
+    struct nl_sock *sk = Nl.GetSock();
+    size_t sent = 0;
+    int ret;
+
+    errors.assign(Msgs.size(), OK);
+
+    while (sent < Msgs.size()) {
+        std::vector<char> buf;
+        uint32_t seq = 0;
+        size_t count = 0;
+
+        /* Kernel handles each message in datagram and acks them in order */
+        while (sent + count < Msgs.size()) {
+            struct nlmsghdr *hdr = nlmsg_hdr(Msgs[sent + count]);
+            size_t len = NLMSG_ALIGN(hdr->nlmsg_len);
+
+            if (count && buf.size() + len > BATCH_SIZE)
+                break;
+
+            hdr->nlmsg_flags |= NLM_F_REQUEST | NLM_F_ACK;
+            hdr->nlmsg_seq = nl_socket_use_seq(sk);
+            hdr->nlmsg_pid = nl_socket_get_local_port(sk);
+            if (!count)
+                seq = hdr->nlmsg_seq;
+
+            buf.insert(buf.end(), (char *)hdr, (char *)hdr + hdr->nlmsg_len);
+            buf.resize(buf.size() + len - hdr->nlmsg_len);
+            count++;
+        }
+
+        ret = nl_sendto(sk, buf.data(), buf.size());
+        if (ret < 0)
+            return Nl.Error(ret, "Cannot send netlink batch");
+
+        for (size_t acked = 0; acked < count; ) {
+            struct sockaddr_nl nla;
+            unsigned char *data = nullptr;
+            int len;
+
+            len = nl_recv(sk, &nla, &data, nullptr);
+            if (len <= 0) {
+                free(data);
+                return Nl.Error(len ?: -NLE_MSG_TRUNC, "Cannot receive netlink batch acks");
+            }
+
+            for (auto hdr = (struct nlmsghdr *)data; nlmsg_ok(hdr, len);
+                    hdr = nlmsg_next(hdr, &len)) {
+                uint32_t index = hdr->nlmsg_seq - seq;
+
+                if (hdr->nlmsg_type != NLMSG_ERROR || index >= count)
+                    continue;
+
+                auto err = (struct nlmsgerr *)nlmsg_data(hdr);
+                if (err->error)
+                    errors[sent + index] = Nl.Error(-nl_syserr2nlerr(-err->error),
+                                                    "Batched netlink request");
+                acked++;
+            }
+
+            free(data);
+        }
+
+        sent += count;
+    }
+
+    return OK;
+}
+
 int TNl::GetFd() {
     return nl_socket_get_fd(Sock);
 }
@@ -875,13 +1066,9 @@ bool TNlClass::Exists(const TNl &nl) {
     return !Load(nl);
 }
 
-TError TNlQdisc::Create(const TNl &nl) {
+TError TNlQdisc::Build(const TNl &nl, struct rtnl_qdisc *&qdisc) const {
     TError error = OK;
     int ret;
-    struct rtnl_qdisc *qdisc;
-
-    if (Kind == "")
-        return Delete(nl);
 
     qdisc = rtnl_qdisc_alloc();
     if (!qdisc)
@@ -934,13 +1121,59 @@ TError TNlQdisc::Create(const TNl &nl) {
             rtnl_qdisc_fq_codel_set_ecn(qdisc, config().network().codel_ecn());
     }
 
+    return OK;
+
+free_qdisc:
+    rtnl_qdisc_put(qdisc);
+    qdisc = nullptr;
+
+    return error;
+}
+
+TError TNlQdisc::Create(const TNl &nl) {
+    struct rtnl_qdisc *qdisc;
+    TError error;
+    int ret;
+
+    if (Kind == "")
+        return Delete(nl);
+
+    error = Build(nl, qdisc);
+    if (error)
+        return error;
+
     nl.Dump("create", qdisc);
 
     ret = rtnl_qdisc_add(nl.GetSock(), qdisc, NLM_F_CREATE  | NLM_F_REPLACE);
     if (ret < 0)
         error = nl.Error(ret, "Cannot create qdisc");
 
-free_qdisc:
+    rtnl_qdisc_put(qdisc);
+
+    return error;
+}
+
+TError TNlQdisc::Create(TNlBatch &batch) {
+    struct rtnl_qdisc *qdisc;
+    struct nl_msg *msg;
+    TError error;
+    int ret;
+
+    if (Kind == "")
+        return TError(EError::NotSupported, "Qdisc removal is not batched");
+
+    error = Build(batch.Nl, qdisc);
+    if (error)
+        return error;
+
+    batch.Nl.Dump("create", qdisc);
+
+    ret = rtnl_qdisc_build_add_request(qdisc, NLM_F_CREATE | NLM_F_REPLACE, &msg);
+    if (ret < 0)
+        error = batch.Nl.Error(ret, "Cannot build qdisc request");
+    else
+        batch.Add(msg);
+
     rtnl_qdisc_put(qdisc);
 
     return error;
@@ -1010,8 +1243,7 @@ out:
     return result;
 }
 
-TError TNlClass::Create(const TNl &nl) {
-    struct rtnl_class *cls;
+TError TNlClass::Build(const TNl &nl, struct rtnl_class *&cls) const {
     TError error;
     int ret;
 
@@ -1093,6 +1325,23 @@ TError TNlClass::Create(const TNl &nl) {
         }
     }
 
+    return OK;
+
+free_class:
+    rtnl_class_put(cls);
+    cls = nullptr;
+    return error;
+}
+
+TError TNlClass::Create(const TNl &nl) {
+    struct rtnl_class *cls;
+    TError error;
+    int ret;
+
+    error = Build(nl, cls);
+    if (error)
+        return error;
+
     nl.Dump("add", cls);
     ret = rtnl_class_add(nl.GetSock(), cls, NLM_F_CREATE | NLM_F_REPLACE);
     if (ret < 0) {
@@ -1103,7 +1352,28 @@ TError TNlClass::Create(const TNl &nl) {
             error = nl.Error(ret, "Cannot add traffic class");
     }
 
-free_class:
+    rtnl_class_put(cls);
+    return error;
+}
+
+TError TNlClass::Create(TNlBatch &batch) {
+    struct rtnl_class *cls;
+    struct nl_msg *msg;
+    TError error;
+    int ret;
+
+    error = Build(batch.Nl, cls);
+    if (error)
+        return error;
+
+    batch.Nl.Dump("add", cls);
+
+    ret = rtnl_class_build_add_request(cls, NLM_F_CREATE | NLM_F_REPLACE, &msg);
+    if (ret < 0)
+        error = batch.Nl.Error(ret, "Cannot build class request");
+    else
+        batch.Add(msg);
+
     rtnl_class_put(cls);
     return error;
 }
@@ -14,6 +14,9 @@ extern "C" {
 struct nl_sock;
 struct rtnl_link;
 struct nl_cache;
+struct nl_msg;
+struct rtnl_qdisc;
+struct rtnl_class;
 struct nl_addr;
 class TNlLink;
 
@@ -48,6 +51,22 @@ public:
 
 uint32_t TcHandle(uint16_t maj, uint16_t min);
 
+struct TNlTcStat {
+    uint64_t Bytes = 0;
+    uint64_t Packets = 0;
+    uint64_t Drops = 0;
+    uint64_t Overlimits = 0;
+
+    bool operator==(const TNlTcStat &a) const {
+        return Bytes == a.Bytes && Packets == a.Packets &&
+               Drops == a.Drops && Overlimits == a.Overlimits;
+    }
+
+    bool operator!=(const TNlTcStat &a) const {
+        return !(*this == a);
+    }
+};
+
 class TNl : public std::enable_shared_from_this<TNl>,
             public TNonCopyable {
     struct nl_sock *Sock = nullptr;
@@ -72,6 +91,14 @@ public:
     TError PermanentNeighbour(int ifindex, const TNlAddr &addr,
                               const TNlAddr &lladdr, bool add);
     TError AddrLabel(const TNlAddr &prefix, uint32_t label);
+
+    /* Multicast notifications, socket becomes nonblocking */
+    TError SubscribeEvents(const std::vector<int> &groups);
+    TError RecvEvents(const std::function<void(struct nl_msg *msg)> &fn);
+
+    /* Single RTM_GETTCLASS dump without building libnl cache */
+    TError DumpClassStat(int index,
+            const std::function<void(uint32_t handle, const TNlTcStat &stat)> &fn) const;
 };
 
 class TNlLink : public TNonCopyable {
@@ -134,7 +161,27 @@ public:
     std::shared_ptr<TNl> GetNl() { return Nl; };
 };
 
+/* Several requests in one sendmsg, each is acked separately */
+class TNlBatch : public TNonCopyable {
+    static constexpr size_t BATCH_SIZE = 16384;
+    std::vector<struct nl_msg *> Msgs;
+
+public:
+    const TNl &Nl;
+
+    TNlBatch(const TNl &nl) : Nl(nl) {}
+    ~TNlBatch();
+
+    size_t Size() const { return Msgs.size(); }
+    void Add(struct nl_msg *msg) { Msgs.push_back(msg); }
+
+    /* Send all requests, errors[i] is result of i-th request */
+    TError Commit(std::vector<TError> &errors);
+};
+
 class TNlQdisc {
+    TError Build(const TNl &nl, struct rtnl_qdisc *&qdisc) const;
+
 public:
     int Index;
     uint32_t Parent, Handle;
@@ -146,11 +193,14 @@ public:
         Index(index), Parent(parent), Handle(handle) {}
 
     TError Create(const TNl &nl);
+    TError Create(TNlBatch &batch);
     TError Delete(const TNl &nl);
     bool Check(const TNl &nl);
 };
 
 class TNlClass {
+    TError Build(const TNl &nl, struct rtnl_class *&cls) const;
+
 public:
     int Index = 0;
     uint32_t Parent = -1;
@@ -169,6 +219,7 @@ public:
         Index(index), Parent(parent), Handle(handle) {}
 
     TError Create(const TNl &nl);
+    TError Create(TNlBatch &batch);
     TError Delete(const TNl &nl);
     TError Load(const TNl &nl);
     bool Exists(const TNl &nl);
@@ -1,5 +1,10 @@
 #include <sstream>
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <thread>
 
 #include "path.hpp"
 #include "util/string.hpp"
@@ -470,39 +475,348 @@ TError TPath::Rmdir() const {
 
 /*
  * Removes everything in the directory but not directory itself.
- * Works only on one filesystem and aborts if sees mountpint.
+ * Works only on one filesystem and skips mountpoints with error.
  */
-TError TPath::ClearDirectory() const {
+TError TPath::ClearDirectory(unsigned threads) const {
     TFile dir;
     TError error = dir.OpenDirStrict(*this);
     if (error)
         return error;
-    return dir.ClearDirectory();
+    return dir.ClearDirectory(threads);
 }
 
-TError TFile::ClearDirectory() const {
-    TPathWalk walk;
-    TError error;
+/*
+ * Directories are read with large getdents64 batches and cleared with
+ * unlinkat relative to their fd, so nothing is resolved by path and
+ * symlinks are never followed. Each worker walks depth-first with its own
+ * stack and keeps only the deepest few directories open, ancestors are
+ * reopened via ".." and checked by inode on the way back. Subdirectories
+ * are handed to other workers while queue is short. Directory is removed
+ * by the last who finishes its subtree. Caller always works, extra workers
+ * are borrowed from limit shared by all removals and may be none.
+ */
+static std::mutex RemoveThreadsMutex;
+static unsigned RemoveThreadsLimit = 0;
+static unsigned RemoveThreadsUsed = 0;
+
+class TTreeRemover {
+    struct TNode {
+        TNode *Parent;
+        std::string Name;
+        ino_t Ino;
+        TFile Dir;
+        std::vector<std::pair<std::string, unsigned char>> Entries;
+        size_t Next = 0;
+        std::atomic<unsigned> Pending;
+    };
+
+    static constexpr size_t BufferSize = 1 << 16;
+    static constexpr size_t MaxOpen = 32;
+
+    unsigned Threads;
+    TRemoveVisitor Visit;
+    std::atomic<bool> Stopped{false};
+    dev_t Dev = 0;
+    int MountId = -1;
+
+    std::mutex Mutex;
+    std::condition_variable Cv;
+    std::list<TNode *> Queue;
+    bool Done = false;
+    TError Error;
+
+    void SetError(const TError &error) {
+        std::lock_guard<std::mutex> lock(Mutex);
+        if (!Error)
+            Error = error;
+    }
 
-    error = Chdir();
-    if (error)
-        return error;
+    bool Visited(const TFile &dir, const std::string &name, const struct stat &st) {
+        if (!Visit)
+            return true;
+        TError error = Visit(dir, name, st);
+        if (!error)
+            return true;
+        SetError(error);
+        Stopped = true;
+        return false;
+    }
 
-    error = walk.OpenNoStat(".");
-    while (!error) {
-        error = walk.Next();
-        if (error || !walk.Path)
-            break;
-        if (walk.Directory) {
-            if (!walk.Postorder || walk.Path == ".")
+    static void MoveFd(TFile &to, TFile &from) {
+        to.Close();
+        to.SetFd = from.Fd;
+        from.SetFd = -1;
+    }
+
+    /* Drop immutable and append-only flags from directory and entry */
+    static TError Unlink(const TFile &dir, const std::string &name, int flags, unsigned char type) {
+        if (!unlinkat(dir.Fd, name.c_str(), flags) || errno == ENOENT)
+            return OK;
+
+        if (errno == EPERM) {
+            (void)TFile::Chattr(dir.Fd, 0, FS_IMMUTABLE_FL | FS_APPEND_FL);
+            if (type == DT_REG || type == DT_DIR) {
+                TFile file;
+                if (!file.OpenAt(dir, name, O_RDONLY | O_NOFOLLOW | O_NONBLOCK |
+                                 O_NOCTTY | O_CLOEXEC, 0))
+                    (void)TFile::Chattr(file.Fd, 0, FS_IMMUTABLE_FL | FS_APPEND_FL);
+            }
+            if (!unlinkat(dir.Fd, name.c_str(), flags) || errno == ENOENT)
+                return OK;
+        }
+
+        return TError::System("unlinkat {}", name);
+    }
+
+    static TError ReadDir(TNode *node, std::vector<char> &buf) {
+        while (1) {
+            long size = syscall(SYS_getdents64, node->Dir.Fd, &buf[0], buf.size());
+            if (size < 0)
+                return TError::System("getdents64");
+            if (!size)
+                return OK;
+            for (long off = 0; off < size; ) {
+                auto de = (struct dirent64 *)(&buf[off]);
+                off += de->d_reclen;
+                if (!strcmp(de->d_name, ".") || !strcmp(de->d_name, ".."))
+                    continue;
+                node->Entries.emplace_back(de->d_name, de->d_type);
+            }
+        }
+    }
+
+    /* Open parent of directory and check that it is still where it was */
+    TError OpenParent(const TFile &dir, const TNode *parent, TFile &up) {
+        struct stat st;
+        TError error;
+
+        if (!dir)
+            return TError(EError::Unknown, "Directory {} is not open", parent->Name);
+
+        error = up.OpenAt(dir, "..", O_RDONLY | O_DIRECTORY | O_NOFOLLOW |
+                          O_NOCTTY | O_CLOEXEC, 0);
+        if (error)
+            return error;
+
+        error = up.Stat(st);
+        if (error)
+            return error;
+
+        if (st.st_dev != Dev || st.st_ino != parent->Ino) {
+            up.Close();
+            return TError(EError::Busy, "Directory {} moved during removal", parent->Name);
+        }
+
+        return OK;
+    }
+
+    /* Drop reference and remove directories which have no more work */
+    void Finish(TNode *node, TFile &dir) {
+        while (!--node->Pending) {
+            TNode *parent = node->Parent;
+            if (!parent) {
+                dir.Close();
+                std::lock_guard<std::mutex> lock(Mutex);
+                Done = true;
+                Cv.notify_all();
+                return;
+            }
+            TFile up;
+            TError error = OpenParent(dir, parent, up);
+            dir.Close();
+            if (!error && !Stopped)
+                error = Unlink(up, node->Name, AT_REMOVEDIR, DT_DIR);
+            if (error)
+                SetError(error);
+            delete node;
+            node = parent;
+            MoveFd(dir, up);
+        }
+        dir.Close();
+    }
+
+    /* Opens subdirectory and counts it as pending work of its parent */
+    TNode *OpenChild(TNode *node, const std::string &name) {
+        struct stat st;
+        TError error;
+
+        TNode *child = new TNode;
+        child->Parent = node;
+        child->Name = name;
+        child->Pending = 1;
+
+        error = child->Dir.OpenAt(node->Dir, name, O_RDONLY | O_DIRECTORY |
+                                  O_NOFOLLOW | O_NOCTTY | O_CLOEXEC, 0);
+        if (!error) {
+            error = child->Dir.Stat(st);
+            if (!error && (st.st_dev != Dev ||
+                           (MountId >= 0 && child->Dir.GetMountId() != MountId)))
+                error = TError(EError::Busy, "Mountpoint {} in directory", name);
+        }
+        if (error) {
+            if (error.Errno != ENOENT)
+                SetError(error);
+            delete child;
+            return nullptr;
+        }
+
+        if (!Visited(node->Dir, name, st)) {
+            delete child;
+            return nullptr;
+        }
+
+        child->Ino = st.st_ino;
+        node->Pending++;
+        return child;
+    }
+
+    void Walk(TNode *start, std::vector<char> &buf) {
+        std::vector<TNode *> stack;
+        TError error;
+
+        stack.push_back(start);
+        error = ReadDir(start, buf);
+        if (error)
+            SetError(error);
+
+        while (!stack.empty()) {
+            TNode *node = stack.back();
+
+            if (node->Next == node->Entries.size() || !node->Dir || Stopped) {
+                stack.pop_back();
+
+                /* Parent was closed to bound fds, reopen it from child */
+                if (!stack.empty() && !stack.back()->Dir) {
+                    error = OpenParent(node->Dir, stack.back(), stack.back()->Dir);
+                    if (error)
+                        SetError(error);
+                }
+
+                node->Entries.clear();
+                node->Entries.shrink_to_fit();
+                TFile dir;
+                MoveFd(dir, node->Dir);
+                Finish(node, dir);
                 continue;
-            error = RmdirAt(walk.Path);
-        } else
-            error = UnlinkAt(walk.Path);
+            }
+
+            auto &ent = node->Entries[node->Next++];
+            struct stat st;
+
+            if (ent.second == DT_UNKNOWN || (Visit && ent.second != DT_DIR)) {
+                if (fstatat(node->Dir.Fd, ent.first.c_str(), &st, AT_SYMLINK_NOFOLLOW))
+                    continue;
+                ent.second = IFTODT(st.st_mode);
+            }
+
+            if (ent.second != DT_DIR) {
+                if (!Visited(node->Dir, ent.first, st))
+                    continue;
+                error = Unlink(node->Dir, ent.first, 0, ent.second);
+                if (error)
+                    SetError(error);
+                continue;
+            }
+
+            TNode *child = OpenChild(node, ent.first);
+            if (!child)
+                continue;
+
+            if (Threads > 1) {
+                std::unique_lock<std::mutex> lock(Mutex);
+                if (Queue.size() < Threads * 4) {
+                    Queue.push_back(child);
+                    Cv.notify_one();
+                    continue;
+                }
+            }
+
+            stack.push_back(child);
+            if (stack.size() > MaxOpen)
+                stack[stack.size() - 1 - MaxOpen]->Dir.Close();
+
+            error = ReadDir(child, buf);
+            if (error)
+                SetError(error);
+        }
     }
 
-    (void)TPath("/").Chdir();
-    return error;
+    void Worker() {
+        std::vector<char> buf(BufferSize);
+        std::unique_lock<std::mutex> lock(Mutex);
+        while (1) {
+            Cv.wait(lock, [&]{ return Done || !Queue.empty(); });
+            if (Queue.empty())
+                break;
+            TNode *node = Queue.front();
+            Queue.pop_front();
+            lock.unlock();
+            Walk(node, buf);
+            lock.lock();
+        }
+    }
+
+public:
+    TTreeRemover(unsigned threads, const TRemoveVisitor &visit) :
+        Threads(std::max(threads, 1u)), Visit(visit) {}
+
+    TError Clear(const TFile &dir) {
+        std::vector<std::thread> workers;
+        struct stat st;
+
+        TNode *root = new TNode;
+        root->Parent = nullptr;
+        root->Pending = 1;
+
+        TError error = root->Dir.Dup(dir);
+        if (!error)
+            error = root->Dir.Stat(st);
+        if (error) {
+            delete root;
+            return error;
+        }
+
+        root->Ino = st.st_ino;
+        Dev = st.st_dev;
+        MountId = root->Dir.GetMountId();
+
+        Queue.push_back(root);
+
+        unsigned extra = 0;
+        if (Threads > 1) {
+            std::lock_guard<std::mutex> lock(RemoveThreadsMutex);
+            extra = RemoveThreadsLimit - std::min(RemoveThreadsLimit, RemoveThreadsUsed);
+            extra = std::min(extra, Threads - 1);
+            RemoveThreadsUsed += extra;
+        }
+        Threads = extra + 1;
+
+        for (unsigned i = 0; i < extra; i++)
+            workers.emplace_back(&TTreeRemover::Worker, this);
+
+        Worker();
+
+        for (auto &worker: workers)
+            worker.join();
+
+        if (extra) {
+            std::lock_guard<std::mutex> lock(RemoveThreadsMutex);
+            RemoveThreadsUsed -= extra;
+        }
+
+        delete root;
+        return Error;
+    }
+};
+
+TError TFile::ClearDirectory(unsigned threads, const TRemoveVisitor &visit) const {
+    TTreeRemover remover(threads, visit);
+    return remover.Clear(*this);
+}
+
+void TFile::SetRemoveThreads(unsigned threads) {
+    std::lock_guard<std::mutex> lock(RemoveThreadsMutex);
+    RemoveThreadsLimit = threads;
 }
 
 TError TFile::RemoveAt(const TPath &path) const {
@@ -520,9 +834,9 @@ TError TFile::RemoveAt(const TPath &path) const {
     return error;
 }
 
-TError TPath::RemoveAll() const {
+TError TPath::RemoveAll(unsigned threads) const {
     if (IsDirectoryStrict()) {
-        TError error = ClearDirectory();
+        TError error = ClearDirectory(threads);
         if (error)
             return error;
         return Rmdir();
@@ -1492,6 +1806,24 @@ TError TFile::SetXAttr(const std::string &name, const std::string &value) const
     return OK;
 }
 
+TError TFile::ListXAttr(std::vector<std::string> &names) const {
+    ssize_t size = syscall(SYS_flistxattr, Fd, nullptr, 0);
+    std::string list;
+
+    names.clear();
+    if (size >= 0) {
+        list.resize(size);
+        size = syscall(SYS_flistxattr, Fd, &list[0], size);
+    }
+    if (size < 0)
+        return TError::System("listxattr");
+
+    for (size_t pos = 0; pos < (size_t)size; pos += names.back().size() + 1)
+        names.emplace_back(list.c_str() + pos);
+
+    return OK;
+}
+
 TError TFile::WalkFollow(const TFile &dir, const TPath &path) {
     if (path.IsAbsolute())
         return TError(EError::InvalidValue, "Absolute path: " + path.Path);
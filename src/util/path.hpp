@@ -3,6 +3,7 @@
 #include <string>
 #include <vector>
 #include <list>
+#include <functional>
 
 #include "util/error.hpp"
 #include "util/cred.hpp"
@@ -154,11 +155,11 @@ public:
     TError MkdirTmp(const TPath &parent, const std::string &prefix, unsigned int mode);
     TError Rmdir() const;
     TError Unlink() const;
-    TError RemoveAll() const;
+    TError RemoveAll(unsigned threads = 1) const;
     TError Rename(const TPath &dest) const;
     TError ReadDirectory(std::vector<std::string> &result) const;
     TError ListSubdirs(std::vector<std::string> &result) const;
-    TError ClearDirectory() const;
+    TError ClearDirectory(unsigned threads = 1) const;
     TError StatFS(TStatFS &result) const;
     TError GetXAttr(const std::string &name, std::string &value) const;
     TError SetXAttr(const std::string &name, const std::string &value) const;
@@ -221,6 +222,12 @@ struct TMount {
     static std::string FormatFlags(uint64_t flags);
 };
 
+class TFile;
+
+/* Called for each entry before it's removed, error stops removal */
+typedef std::function<TError(const TFile &dir, const std::string &name,
+                             const struct stat &st)> TRemoveVisitor;
+
 class TFile {
 public:
     union {
@@ -279,10 +286,13 @@ public:
     TError Touch() const;
     TError GetXAttr(const std::string &name, std::string &value) const;
     TError SetXAttr(const std::string &name, const std::string &value) const;
+    TError ListXAttr(std::vector<std::string> &names) const;
     TError WalkFollow(const TFile &dir, const TPath &path);
     TError WalkStrict(const TFile &dir, const TPath &path);
     TError Chdir() const;
-    TError ClearDirectory() const;
+    TError ClearDirectory(unsigned threads = 1, const TRemoveVisitor &visit = nullptr) const;
+    /* Limit of extra threads shared by all concurrent ClearDirectory */
+    static void SetRemoveThreads(unsigned threads);
     bool IsDirectory() const;
     TError Stat(struct stat &st) const;
     TError StatAt(const TPath &path, bool follow, struct stat &st) const;
@@ -10,6 +10,7 @@ extern "C" {
 }
 
 void Crash() {
+    FlushLog();
     L_ERR("Crashed");
     Stacktrace();
 
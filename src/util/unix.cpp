@@ -33,6 +33,8 @@ extern "C" {
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sched.h>
 #include <linux/fs.h>
 }
 
@@ -65,6 +67,25 @@ bool TTask::IsZombie() const {
     return state == 'Z';
 }
 
+/* Wait status of not yet reaped zombie, works for any parent */
+TError TTask::GetExitStatus(int &status) const {
+    std::string path = "/proc/" + std::to_string(Pid) + "/stat";
+    FILE *file;
+    char state;
+    int res;
+
+    file = fopen(path.c_str(), "r");
+    if (!file)
+        return TError::System("fopen " + path);
+    res = fscanf(file, "%*d (%*[^)]) %c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %*u %*u %*d %*d %*d %*d %*d %*d %*u %*u %*d %*u %*u %*u %*u %*u %*u %*u %*u %*u %*u %*u %*u %*u %*d %*d %*u %*u %*u %*u %*d %*u %*u %*u %*u %*u %*u %*u %d", &state, &status);
+    fclose(file);
+    if (res != 2)
+        return TError("Cannot parse " + path);
+    if (state != 'Z')
+        return TError(EError::InvalidState, "Task {} is not zombie", Pid);
+    return OK;
+}
+
 pid_t TTask::GetPPid() const {
     std::string path = "/proc/" + std::to_string(Pid) + "/stat";
     int res, ppid;
@@ -98,6 +119,17 @@ pid_t GetPid() {
     return syscall(SYS_getpid);
 }
 
+/* Returns -1 with ENOSYS if kernel or headers have no pidfd */
+int PidFdOpen(pid_t pid) {
+#ifdef SYS_pidfd_open
+    return syscall(SYS_pidfd_open, pid, 0);
+#else
+    (void)pid;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
 pid_t GetPPid() {
     return syscall(SYS_getppid);
 }
@@ -425,6 +457,40 @@ TError TUnixSocket::RecvError() const {
     return error;
 }
 
+TError TUnixSocket::SendString(const std::string &str) const {
+    TError error = SendInt(str.size());
+    if (error || str.empty())
+        return error;
+
+    ssize_t ret = write(SockFd, str.data(), str.size());
+    if (ret < 0)
+        return TError::System("cannot send string");
+    if (ret != (ssize_t)str.size())
+        return TError("partial write of string: {}", ret);
+    return OK;
+}
+
+TError TUnixSocket::RecvString(std::string &str) const {
+    int len;
+
+    TError error = RecvInt(len);
+    if (error)
+        return error;
+    if (len < 0 || len > (1 << 20))
+        return TError("invalid string length: {}", len);
+
+    str.resize(len);
+    if (!len)
+        return OK;
+
+    ssize_t ret = recv(SockFd, &str[0], len, MSG_WAITALL);
+    if (ret < 0)
+        return TError::System("cannot receive string");
+    if (ret != len)
+        return TError("partial read of string: {}", ret);
+    return OK;
+}
+
 TError TUnixSocket::SendFd(int fd) const {
     char data[1];
     struct iovec iovec = {
@@ -608,14 +674,48 @@ TError TTask::Fork(bool detach) {
     return OK;
 }
 
-TError TTask::Wait() {
+/*
+ * Child shares memory with caller which is suspended until child exits or
+ * execs, page tables aren't copied. Child must not touch shared state and
+ * must not block. ForkLock isn't held while caller is suspended. Child has
+ * no exit signal, so it's never reaped by Deliver, only by Wait.
+ */
+TError TTask::VFork(int (*fn)(void *), void *arg) {
+    PORTO_ASSERT(!PostFork);
+    size_t stack_size = 1 << 20;
+    void *stack = mmap(NULL, stack_size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+    if (stack == MAP_FAILED)
+        return TError::System("mmap");
+    auto lock = std::unique_lock<std::mutex>(ForkLock);
+    ForkTime = time(NULL);
+    localtime_r(&ForkTime, &ForkLocalTime);
+    lock.unlock();
+    pid_t ret = clone(fn, (char *)stack + stack_size, CLONE_VM | CLONE_VFORK, arg);
+    int err = errno;
+    munmap(stack, stack_size);
+    if (ret < 0)
+        return TError(EError::Unknown, err, "TTask::VFork");
+    lock.lock();
+    Pid = ret;
+    Tasks[Pid] = this;
+    Running = true;
+    return OK;
+}
+
+void TTask::ForkedChild() {
+    PostFork = true;
+}
+
+/* Usage is reported only if task is reaped here rather than in Deliver */
+TError TTask::Wait(struct rusage *usage) {
     auto lock = std::unique_lock<std::mutex>(ForkLock);
     if (Running) {
         pid_t pid = Pid;
         int status;
         lock.unlock();
         /* main thread could be blocked on lock that we're holding */
-        if (waitpid(pid, &status, 0) == pid)
+        if (wait4(pid, &status, __WALL, usage) == pid)
             pid = 0;
         lock.lock();
         if (!pid) {
@@ -21,11 +21,14 @@ struct TTask {
     bool Running = false;
 
     TError Fork(bool detach = false);
-    TError Wait();
+    TError VFork(int (*fn)(void *), void *arg);
+    static void ForkedChild();
+    TError Wait(struct rusage *usage = nullptr);
     static bool Deliver(pid_t pid, int status);
 
     bool Exists() const;
     bool IsZombie() const;
+    TError GetExitStatus(int &status) const;
     pid_t GetPPid() const;
     TError Kill(int signal) const;
 };
@@ -34,6 +37,7 @@ std::string FormatTime(time_t t, const char *fmt = "%F %T");
 void LocalTime(const time_t *time, struct tm &tm);
 
 pid_t GetPid();
+int PidFdOpen(pid_t pid);
 pid_t GetPPid();
 pid_t GetTid();
 TError GetTaskChildrens(pid_t pid, std::vector<pid_t> &childrens);
@@ -79,6 +83,8 @@ public:
     TError RecvPid(pid_t &pid, pid_t &vpid) const;
     TError SendError(const TError &error) const;
     TError RecvError() const;
+    TError SendString(const std::string &str) const;
+    TError RecvString(std::string &str) const;
     TError SendFd(int fd) const;
     TError RecvFd(int &fd) const;
     TError SetRecvTimeout(int timeout_ms) const;
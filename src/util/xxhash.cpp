@@ -0,0 +1,126 @@
+/*
+ * Implementation of XXH64 hash function by Yann Collet.
+ *
+ * Algorithm is described in https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md
+ * Digest matches reference implementation on little-endian machines.
+ */
+
+#include "util/xxhash.hpp"
+
+#include <cstring>
+
+static const uint64_t P1 = 11400714785074694791ULL;
+static const uint64_t P2 = 14029467366897019727ULL;
+static const uint64_t P3 = 1609587929392839161ULL;
+static const uint64_t P4 = 9650029242287828579ULL;
+static const uint64_t P5 = 2870177450012600261ULL;
+
+static inline uint64_t Rotl(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t Read64(const unsigned char *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t Read32(const unsigned char *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t Round(uint64_t acc, uint64_t input) {
+    acc += input * P2;
+    acc = Rotl(acc, 31);
+    return acc * P1;
+}
+
+static inline uint64_t MergeRound(uint64_t acc, uint64_t val) {
+    acc ^= Round(0, val);
+    return acc * P1 + P4;
+}
+
+TXxh64::TXxh64(uint64_t seed) {
+    V1 = seed + P1 + P2;
+    V2 = seed + P2;
+    V3 = seed;
+    V4 = seed - P1;
+}
+
+void TXxh64::Update(const void *data, size_t len) {
+    const unsigned char *p = (const unsigned char *)data;
+    const unsigned char *end = p + len;
+
+    Length += len;
+
+    if (MemSize + len < 32) {
+        memcpy(Mem + MemSize, p, len);
+        MemSize += len;
+        return;
+    }
+
+    if (MemSize) {
+        memcpy(Mem + MemSize, p, 32 - MemSize);
+        p += 32 - MemSize;
+        V1 = Round(V1, Read64(Mem));
+        V2 = Round(V2, Read64(Mem + 8));
+        V3 = Round(V3, Read64(Mem + 16));
+        V4 = Round(V4, Read64(Mem + 24));
+        MemSize = 0;
+    }
+
+    for (; p + 32 <= end; p += 32) {
+        V1 = Round(V1, Read64(p));
+        V2 = Round(V2, Read64(p + 8));
+        V3 = Round(V3, Read64(p + 16));
+        V4 = Round(V4, Read64(p + 24));
+    }
+
+    if (p < end) {
+        memcpy(Mem, p, end - p);
+        MemSize = end - p;
+    }
+}
+
+uint64_t TXxh64::Digest() const {
+    const unsigned char *p = Mem;
+    const unsigned char *end = Mem + MemSize;
+    uint64_t h;
+
+    if (Length >= 32) {
+        h = Rotl(V1, 1) + Rotl(V2, 7) + Rotl(V3, 12) + Rotl(V4, 18);
+        h = MergeRound(h, V1);
+        h = MergeRound(h, V2);
+        h = MergeRound(h, V3);
+        h = MergeRound(h, V4);
+    } else
+        h = V3 + P5; /* seed */
+
+    h += Length;
+
+    for (; p + 8 <= end; p += 8) {
+        h ^= Round(0, Read64(p));
+        h = Rotl(h, 27) * P1 + P4;
+    }
+
+    if (p + 4 <= end) {
+        h ^= (uint64_t)Read32(p) * P1;
+        h = Rotl(h, 23) * P2 + P3;
+        p += 4;
+    }
+
+    for (; p < end; p++) {
+        h ^= *p * P5;
+        h = Rotl(h, 11) * P1;
+    }
+
+    h ^= h >> 33;
+    h *= P2;
+    h ^= h >> 29;
+    h *= P3;
+    h ^= h >> 32;
+
+    return h;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+/* Streaming XXH64, see https://github.com/Cyan4973/xxHash */
+class TXxh64 {
+    uint64_t V1, V2, V3, V4;
+    uint64_t Length = 0;
+    unsigned char Mem[32];
+    size_t MemSize = 0;
+
+public:
+    TXxh64(uint64_t seed = 0);
+    void Update(const void *data, size_t len);
+    uint64_t Digest() const;
+};
@@ -1,6 +1,9 @@
 #include <sstream>
 #include <algorithm>
 #include <condition_variable>
+#include <thread>
+#include <queue>
+#include <atomic>
 
 #include "volume.hpp"
 #include "storage.hpp"
@@ -35,6 +38,13 @@ static uint64_t NextId = 1;
 
 static std::condition_variable VolumesCv;
 
+/* Pre-built volumes by configuration key, protected with VolumesMutex */
+static std::map<std::string, std::list<std::shared_ptr<TVolume>>> VolumePool;
+static std::shared_ptr<TVolume> VolumePoolBuilding;
+static std::condition_variable VolumePoolCv;
+static std::thread VolumePoolThread;
+static bool VolumePoolStop = false;
+
 /* TVolumeBackend - abstract */
 
 TError TVolumeBackend::Configure() {
@@ -439,63 +449,237 @@ public:
     }
 };
 
-static TError SetupLoopDev(const TFile &file, const TPath &path, int &loopNr) {
-    static std::mutex BigLoopLock;
-    TFile ctl, dev;
+/*
+ * Loop devices are taken from pool of detached devices reserved by porto,
+ * so parallel volumes don't race for single LOOP_CTL_GET_FREE result.
+ */
+static std::mutex LoopMutex;
+static std::vector<int> LoopPool;
+static std::set<int> LoopTaken;
+static std::atomic<bool> LoopConfigure(true);
+
+static bool LoopDevFree(int nr) {
     struct loop_info64 info;
-    int nr, retry = 10;
-    TError error;
+    TFile dev;
 
-    error = ctl.OpenReadWrite("/dev/loop-control");
-    if (error)
-        return error;
+    if (dev.OpenReadWrite("/dev/loop" + std::to_string(nr)))
+        return false;
+    return ioctl(dev.Fd, LOOP_GET_STATUS64, &info) < 0 && errno == ENXIO;
+}
 
-    if (config().volumes().direct_io_loop() &&
-            fcntl(file.Fd, F_SETFL, fcntl(file.Fd, F_GETFL) | O_DIRECT))
-        L("Cannot enable O_DIRECT for loop {}", TError::System("fcntl"));
+static TError RefillLoopPool(std::unique_lock<std::mutex> &lock, size_t size) {
+    PORTO_ASSERT(lock.owns_lock());
+    TFile ctl;
 
-    auto lock = std::unique_lock<std::mutex>(BigLoopLock);
+    TError error = ctl.OpenReadWrite("/dev/loop-control");
+    if (error)
+        return error;
 
-again:
-    nr = ioctl(ctl.Fd, LOOP_CTL_GET_FREE);
+    int nr = ioctl(ctl.Fd, LOOP_CTL_GET_FREE);
     if (nr < 0)
         return TError::System("ioctl(LOOP_CTL_GET_FREE)");
 
-    error = dev.OpenReadWrite("/dev/loop" + std::to_string(nr));
+    for (int scan = 0; LoopPool.size() < size && scan < 1024; scan++, nr++) {
+        if (LoopTaken.count(nr) ||
+                std::find(LoopPool.begin(), LoopPool.end(), nr) != LoopPool.end())
+            continue;
+        if (ioctl(ctl.Fd, LOOP_CTL_ADD, nr) < 0) {
+            if (errno != EEXIST)
+                return TError::System("ioctl(LOOP_CTL_ADD, {})", nr);
+            if (!LoopDevFree(nr))
+                continue;
+        }
+        LoopPool.push_back(nr);
+    }
+
+    if (LoopPool.empty())
+        return TError(EError::ResourceNotAvailable, "No free loop devices");
+
+    return OK;
+}
+
+static void FillLoopPool() {
+    auto lock = std::unique_lock<std::mutex>(LoopMutex);
+    TError error = RefillLoopPool(lock, config().volumes().loop_pool_size());
     if (error)
-        return error;
+        L_WRN("Cannot fill loop pool: {}", error);
+}
 
-    if (ioctl(dev.Fd, LOOP_SET_FD, file.Fd) < 0) {
-        if (errno == EBUSY) {
-            if (!ioctl(dev.Fd, LOOP_GET_STATUS64, &info) || errno == ENXIO) {
-                if (--retry > 0)
-                    goto again;
-            }
-        }
-        return TError::System("ioctl(LOOP_SET_FD)");
+static TError GetLoopNr(int &nr) {
+    auto lock = std::unique_lock<std::mutex>(LoopMutex);
+
+    if (LoopPool.empty()) {
+        TError error = RefillLoopPool(lock, std::max(config().volumes().loop_pool_size(), 1u));
+        if (error)
+            return error;
     }
 
+    nr = LoopPool.back();
+    LoopPool.pop_back();
+    LoopTaken.insert(nr);
+    return OK;
+}
+
+static void ReleaseLoopNr(int nr, bool recycle) {
+    auto lock = std::unique_lock<std::mutex>(LoopMutex);
+
+    LoopTaken.erase(nr);
+    if (recycle && LoopPool.size() < config().volumes().loop_pool_size())
+        LoopPool.push_back(nr);
+}
+
+static TError BindLoopDev(const TFile &dev, const TFile &file,
+                          const TPath &path, bool direct_io) {
+    struct loop_info64 info;
+
     memset(&info, 0, sizeof(info));
     strncpy((char *)info.lo_file_name, path.c_str(), LO_NAME_SIZE - 1);
 
+#ifdef LOOP_CONFIGURE
+    if (LoopConfigure) {
+        struct loop_config cfg;
+
+        memset(&cfg, 0, sizeof(cfg));
+        cfg.fd = file.Fd;
+        cfg.info = info;
+        if (direct_io)
+            cfg.info.lo_flags |= LO_FLAGS_DIRECT_IO;
+
+        if (!ioctl(dev.Fd, LOOP_CONFIGURE, &cfg))
+            return OK;
+        if (errno != EINVAL && errno != ENOTTY)
+            return TError::System("ioctl(LOOP_CONFIGURE)");
+        L("LOOP_CONFIGURE is not supported, fallback to LOOP_SET_FD");
+        LoopConfigure = false;
+    }
+#endif
+
+    if (ioctl(dev.Fd, LOOP_SET_FD, file.Fd) < 0)
+        return TError::System("ioctl(LOOP_SET_FD)");
+
     if (ioctl(dev.Fd, LOOP_SET_STATUS64, &info) < 0) {
-        error = TError::System("ioctl(LOOP_SET_STATUS64)");
+        TError error = TError::System("ioctl(LOOP_SET_STATUS64)");
         (void)ioctl(dev.Fd, LOOP_CLR_FD, 0);
         return error;
     }
 
-    loopNr = nr;
-    return error;
+    return OK;
+}
+
+static TError SetupLoopDev(const TFile &file, const TPath &path,
+                           int &loopNr, bool direct_io) {
+    int nr, retry = 10;
+    TError error;
+
+    if (direct_io &&
+            fcntl(file.Fd, F_SETFL, fcntl(file.Fd, F_GETFL) | O_DIRECT))
+        L("Cannot enable O_DIRECT for loop {}", TError::System("fcntl"));
+
+    while (1) {
+        TFile dev;
+
+        error = GetLoopNr(nr);
+        if (error)
+            return error;
+
+        error = dev.OpenReadWrite("/dev/loop" + std::to_string(nr));
+        if (!error)
+            error = BindLoopDev(dev, file, path, direct_io);
+
+        /* Device was grabbed outside or is still detaching, forget it */
+        if (error && error.Errno == EBUSY && --retry > 0) {
+            ReleaseLoopNr(nr, false);
+            continue;
+        }
+
+        if (error) {
+            ReleaseLoopNr(nr, true);
+            return error;
+        }
+
+        loopNr = nr;
+        return OK;
+    }
 }
 
 TError PutLoopDev(const int loopNr) {
     TFile loop;
     TError error = loop.OpenReadWrite("/dev/loop" + std::to_string(loopNr));
     if (!error && ioctl(loop.Fd, LOOP_CLR_FD, 0) < 0)
-        return TError::System("ioctl(LOOP_CLR_FD)");
+        error = TError::System("ioctl(LOOP_CLR_FD)");
+    ReleaseLoopNr(loopNr, !error);
     return error;
 }
 
+/*
+ * Each squash image is attached to one loop device shared by all volumes,
+ * they mount it separately but kernel reuses superblock and page cache.
+ */
+struct TSquashDev {
+    int Device;
+    unsigned Users;
+};
+
+static std::mutex SquashMutex;
+static std::map<std::string, TSquashDev> SquashDevs;
+
+static std::string SquashKey(const TFile &image) {
+    struct stat st;
+    if (image.Stat(st))
+        return "";
+    return fmt::format("{}:{}:{}:{}", st.st_dev, st.st_ino, st.st_size, st.st_mtime);
+}
+
+static TError GetSquashDev(const TFile &image, const TPath &path, int &loopNr) {
+    auto key = SquashKey(image);
+    auto lock = std::unique_lock<std::mutex>(SquashMutex);
+
+    auto it = SquashDevs.find(key);
+    if (key.size() && it != SquashDevs.end()) {
+        it->second.Users++;
+        loopNr = it->second.Device;
+        L_ACT("Share loop{} for {} users {}", loopNr, path, it->second.Users);
+        return OK;
+    }
+
+    TError error = SetupLoopDev(image, path, loopNr, config().volumes().direct_io_loop());
+    if (!error && key.size())
+        SquashDevs[key] = {loopNr, 1};
+
+    return error;
+}
+
+static void RestoreSquashDev(const TPath &path, int loopNr) {
+    TFile image;
+
+    if (image.OpenRead(path))
+        return;
+
+    auto key = SquashKey(image);
+    auto lock = std::unique_lock<std::mutex>(SquashMutex);
+
+    auto it = SquashDevs.find(key);
+    if (it == SquashDevs.end())
+        SquashDevs[key] = {loopNr, 1};
+    else if (it->second.Device == loopNr)
+        it->second.Users++;
+}
+
+static TError PutSquashDev(int loopNr) {
+    auto lock = std::unique_lock<std::mutex>(SquashMutex);
+
+    for (auto it = SquashDevs.begin(); it != SquashDevs.end(); ++it) {
+        if (it->second.Device == loopNr) {
+            if (--it->second.Users)
+                return OK;
+            SquashDevs.erase(it);
+            break;
+        }
+    }
+
+    return PutLoopDev(loopNr);
+}
+
 /* TVolumeLoopBackend - ext4 image + loop device */
 
 class TVolumeLoopBackend : public TVolumeBackend {
@@ -550,7 +734,8 @@ public:
                            "cannot fallocate guarantee " + std::to_string(guarantee));
 
         return RunCommand({ "mkfs.ext4", "-q", "-F", "-m", "0", "-E", "nodiscard",
-                            "-O", "^has_journal", path.ToString()}, dir);
+                            "-O", "^has_journal", path.ToString()}, dir,
+                          TFile(), TFile(), HelperCapabilities, true);
     }
 
     static TError ResizeImage(const TFile &file, const TFile &dir, const TPath &path,
@@ -631,12 +816,23 @@ public:
                 return error;
         }
 
-        error = SetupLoopDev(file, path, Volume->Device);
+        /* Existing image without space_limit is preallocated as is */
+        uint64_t size = Volume->SpaceLimit ? Volume->SpaceLimit : (uint64_t)st.st_size;
+        if (Volume->Preallocate && !Volume->IsReadOnly && size &&
+                fallocate(file.Fd, 0, 0, size))
+            return TError(EError::ResourceNotAvailable, errno,
+                          "cannot fallocate " + std::to_string(size));
+
+        error = SetupLoopDev(file, path, Volume->Device, Volume->DirectIo);
         if (error)
             return error;
 
+        std::vector<std::string> options;
+        if (Volume->Discard)
+            options.push_back("discard");
+
         error = Volume->InternalPath.Mount(GetLoopDevice(), "ext4",
-                                           Volume->GetMountFlags(), {});
+                                           Volume->GetMountFlags(), options);
         if (error) {
             PutLoopDev(Volume->Device);
             Volume->Device = -1;
@@ -899,7 +1095,7 @@ public:
         if (error)
             return error;
 
-        error = SetupLoopDev(lowerFd, Volume->Layers[0], Volume->Device);
+        error = GetSquashDev(lowerFd, Volume->Layers[0], Volume->Device);
         if (error)
             return error;
 
@@ -992,7 +1188,7 @@ err:
                 (void)quota.Destroy();
             if (Volume->Device >= 0) {
                 lower.UmountAll();
-                PutLoopDev(Volume->Device);
+                PutSquashDev(Volume->Device);
                 Volume->Device = -1;
             }
         }
@@ -1000,11 +1196,17 @@ err:
         return error;
     }
 
+    TError Restore() override {
+        if (Volume->Device >= 0)
+            RestoreSquashDev(Volume->Layers[0], Volume->Device);
+        return OK;
+    }
+
     TError Destroy() override {
         if (Volume->Device >= 0) {
             Volume->InternalPath.UmountAll();
             Volume->GetInternal("lower").UmountAll();
-            PutLoopDev(Volume->Device);
+            PutSquashDev(Volume->Device);
             Volume->Device = -1;
         }
 
@@ -1789,6 +1991,13 @@ TError TVolume::Configure(const TPath &target_root, const TStringMap &cfg) {
             return TError(EError::InvalidValue, "Cannot copy layers to read-only volume");
     }
 
+    if (BackendType == "loop") {
+        if (!cfg.count(V_DIRECT_IO))
+            DirectIo = config().volumes().direct_io_loop();
+    } else if (cfg.count(V_DIRECT_IO) || cfg.count(V_DISCARD) || cfg.count(V_PREALLOCATE))
+        return TError(EError::InvalidProperty, "{}, {} and {} are supported only for loop backend",
+                      V_DIRECT_IO, V_DISCARD, V_PREALLOCATE);
+
     /* Verify guarantees */
     if (cfg.count(V_SPACE_LIMIT) && cfg.count(V_SPACE_GUARANTEE) &&
             SpaceLimit < SpaceGuarantee)
@@ -1930,24 +2139,9 @@ TError TVolume::Build() {
             return error;
     }
 
-    /* Initialize cred and perms but do not change is user havn't asked */
-    if (!IsReadOnly) {
-        if (!KeepStorage || !VolumeCred.IsUnknown()) {
-            TCred cred = VolumeCred;
-            if (cred.Uid == NoUser)
-                cred.Uid = CL->TaskCred.Uid;
-            if (cred.Gid == NoGroup)
-                cred.Gid = CL->TaskCred.Gid;
-            error = InternalPath.Chown(cred);
-            if (error)
-                return error;
-        }
-        if (!KeepStorage || VolumePerms) {
-            error = InternalPath.Chmod(VolumePerms ?: 0775);
-            if (error)
-                return error;
-        }
-    }
+    error = InitCred();
+    if (error)
+        return error;
 
     /* Make sure than we saved this before publishing */
     error = Save();
@@ -1965,6 +2159,254 @@ TError TVolume::Build() {
     return OK;
 }
 
+/* Initialize cred and perms but do not change is user havn't asked */
+TError TVolume::InitCred() {
+    TError error;
+
+    if (IsReadOnly)
+        return OK;
+
+    if (!KeepStorage || !VolumeCred.IsUnknown()) {
+        TCred cred = VolumeCred;
+        if (cred.Uid == NoUser)
+            cred.Uid = CL->TaskCred.Uid;
+        if (cred.Gid == NoGroup)
+            cred.Gid = CL->TaskCred.Gid;
+        error = InternalPath.Chown(cred);
+        if (error)
+            return error;
+    }
+
+    if (!KeepStorage || VolumePerms) {
+        error = InternalPath.Chmod(VolumePerms ?: 0775);
+        if (error)
+            return error;
+    }
+
+    return OK;
+}
+
+/* Volumes with internal storage and auto path are interchangeable */
+bool TVolume::Poolable() const {
+    if (!IsAutoPath || Path != InternalPath || HaveStorage() || RemoteStorage() ||
+            IsReadOnly || SpaceGuarantee || InodeGuarantee)
+        return false;
+    for (auto &layer: Layers)
+        if (layer[0] == '/')
+            return false;
+    return true;
+}
+
+std::string TVolume::PoolKey() const {
+    return fmt::format("{} {} {} {} {} {}{}{}", BackendType, Place,
+                       MergeEscapeStrings(Layers, ';'), SpaceLimit, InodeLimit,
+                       DirectIo, Discard, Preallocate);
+}
+
+/* Replaces configured volume with pre-built one, refill is asynchronous */
+static bool TakePooledVolume(std::shared_ptr<TVolume> &volume) {
+    PORTO_LOCKED(VolumesMutex);
+
+    if (!volume->Poolable())
+        return false;
+
+    auto it = VolumePool.find(volume->PoolKey());
+    if (it == VolumePool.end() || it->second.empty())
+        return false;
+
+    auto pooled = it->second.front();
+    it->second.pop_front();
+    Statistics->VolumesPooled--;
+    Statistics->VolumePoolHits++;
+    VolumePoolCv.notify_all();
+
+    pooled->VolumeOwner = volume->VolumeOwner;
+    pooled->VolumeCred = volume->VolumeCred;
+    pooled->VolumePerms = volume->VolumePerms;
+    pooled->Creator = volume->Creator;
+    pooled->Private = volume->Private;
+
+    volume = pooled;
+    return true;
+}
+
+TError TVolume::Adopt() {
+    L_ACT("Adopt pre-built volume: {} backend: {}", Path, BackendType);
+
+    for (auto &name: Layers)
+        (void)TStorage(EStorageType::Layer, Place, name).Touch();
+
+    TError error = InitCred();
+    if (error)
+        return error;
+
+    return Save();
+}
+
+static TError BuildPooledVolume(const TStringMap &cfg, std::shared_ptr<TVolume> &volume) {
+    TError error;
+
+    if (cfg.count(V_PLACE)) {
+        error = TStorage::CheckPlace(cfg.at(V_PLACE));
+        if (error)
+            return error;
+    }
+
+    auto volumes_lock = LockVolumes();
+
+    volume = std::make_shared<TVolume>();
+    volume->Id = std::to_string(NextId++);
+
+    error = volume->Configure("/", cfg);
+    if (error)
+        return error;
+
+    if (!volume->Poolable())
+        return TError(EError::InvalidValue, "Volume {} cannot be pooled", volume->PoolKey());
+
+    volume->SetState(EVolumeState::Building);
+    VolumePoolBuilding = volume;
+    volumes_lock.unlock();
+
+    error = volume->Build();
+
+    volumes_lock.lock();
+    VolumePoolBuilding = nullptr;
+    if (!error)
+        volume->SetState(EVolumeState::Ready);
+    return error;
+}
+
+/* Pooled volumes aren't listed in Volumes but keep their layers mounted */
+std::shared_ptr<TVolume> TVolume::FindPooledLayer(const TPath &place, const std::string &layer) {
+    PORTO_LOCKED(VolumesMutex);
+
+    auto uses = [&](const std::shared_ptr<TVolume> &volume) {
+        return volume && volume->Place == place &&
+            std::find(volume->Layers.begin(), volume->Layers.end(), layer) != volume->Layers.end();
+    };
+
+    if (uses(VolumePoolBuilding))
+        return VolumePoolBuilding;
+
+    for (auto &it: VolumePool)
+        for (auto &volume: it.second)
+            if (uses(volume))
+                return volume;
+
+    return nullptr;
+}
+
+/* Destroys pre-built volumes which use layer, pool refills itself later */
+void TVolume::DropPooledLayer(const TPath &place, const std::string &layer) {
+    std::list<std::shared_ptr<TVolume>> dropped;
+    auto lock = LockVolumes();
+
+    for (auto &it: VolumePool) {
+        for (auto vol = it.second.begin(); vol != it.second.end(); ) {
+            if ((*vol)->Place == place &&
+                    std::find((*vol)->Layers.begin(), (*vol)->Layers.end(), layer) != (*vol)->Layers.end()) {
+                dropped.push_back(*vol);
+                vol = it.second.erase(vol);
+                Statistics->VolumesPooled--;
+            } else
+                vol++;
+        }
+    }
+
+    lock.unlock();
+
+    for (auto &volume: dropped) {
+        L_ACT("Drop pre-built volume {} using layer {}", volume->Path, layer);
+        TError error = volume->Destroy();
+        if (error)
+            L_WRN("Cannot destroy pre-built volume {}: {}", volume->Path, error);
+    }
+}
+
+void TVolume::PoolRefill() {
+    SetProcessName("portod-VP");
+    CL = &SystemClient;
+
+    std::vector<std::pair<TStringMap, unsigned>> pools;
+
+    for (auto &cfg: config().volumes().pool()) {
+        TStringMap map;
+        if (cfg.has_place())
+            map[V_PLACE] = cfg.place();
+        if (cfg.has_backend())
+            map[V_BACKEND] = cfg.backend();
+        if (cfg.has_layers())
+            map[V_LAYERS] = cfg.layers();
+        if (cfg.has_space_limit())
+            map[V_SPACE_LIMIT] = std::to_string(cfg.space_limit());
+        if (cfg.has_inode_limit())
+            map[V_INODE_LIMIT] = std::to_string(cfg.inode_limit());
+        pools.emplace_back(map, cfg.size());
+    }
+
+    /* Pool key is known after first volume is configured */
+    std::vector<std::string> keys(pools.size());
+    auto lock = LockVolumes();
+
+    while (!VolumePoolStop) {
+        bool built = false, failed = false;
+
+        for (unsigned i = 0; i < pools.size() && !VolumePoolStop; i++) {
+            if (keys[i].size() && VolumePool[keys[i]].size() >= pools[i].second)
+                continue;
+
+            lock.unlock();
+
+            std::shared_ptr<TVolume> volume;
+            TError error = BuildPooledVolume(pools[i].first, volume);
+            if (error) {
+                L_WRN("Cannot build pooled volume: {}", error);
+                if (volume)
+                    (void)volume->Destroy();
+            }
+
+            lock.lock();
+
+            if (error) {
+                failed = true;
+                continue;
+            }
+
+            keys[i] = volume->PoolKey();
+            VolumePool[keys[i]].push_back(volume);
+            Statistics->VolumesPooled++;
+            built = true;
+        }
+
+        if (failed)
+            VolumePoolCv.wait_for(lock, std::chrono::seconds(10));
+        else if (!built && !VolumePoolStop)
+            VolumePoolCv.wait(lock);
+    }
+
+    CL = nullptr;
+}
+
+void TVolume::StartPool() {
+    FillLoopPool();
+    if (!config().volumes().pool_size())
+        return;
+    VolumePoolStop = false;
+    VolumePoolThread = std::thread(&TVolume::PoolRefill);
+}
+
+/* Pooled volumes have no links and will be destroyed after restart */
+void TVolume::StopPool() {
+    if (!VolumePoolThread.joinable())
+        return;
+    auto lock = LockVolumes();
+    VolumePoolStop = true;
+    VolumePoolCv.notify_all();
+    lock.unlock();
+    VolumePoolThread.join();
+}
+
 TError TVolume::MountLink(std::shared_ptr<TVolumeLink> link) {
     TError error, error2;
 
@@ -2715,6 +3157,11 @@ void TVolume::Dump(TVolumeLink *link, const TPath &path, rpc::TVolumeDescription
     ret[V_STATE] = StateName(State);
     ret[V_PRIVATE] = Private;
     ret[V_READ_ONLY] = BoolToString(IsReadOnly);
+    if (BackendType == "loop") {
+        ret[V_DIRECT_IO] = BoolToString(DirectIo);
+        ret[V_DISCARD] = BoolToString(Discard);
+        ret[V_PREALLOCATE] = BoolToString(Preallocate);
+    }
     ret[V_SPACE_LIMIT] = std::to_string(SpaceLimit);
     ret[V_INODE_LIMIT] = std::to_string(InodeLimit);
     ret[V_SPACE_GUARANTEE] = std::to_string(SpaceGuarantee);
@@ -2832,6 +3279,11 @@ TError TVolume::Save() {
     node.Set(V_PRIVATE, Private);
     node.Set(V_LOOP_DEV, std::to_string(Device));
     node.Set(V_READ_ONLY, BoolToString(IsReadOnly));
+    if (BackendType == "loop") {
+        node.Set(V_DIRECT_IO, BoolToString(DirectIo));
+        node.Set(V_DISCARD, BoolToString(Discard));
+        node.Set(V_PREALLOCATE, BoolToString(Preallocate));
+    }
     node.Set(V_LAYERS, MergeEscapeStrings(Layers, ';'));
     node.Set(V_SPACE_LIMIT, std::to_string(SpaceLimit));
     node.Set(V_SPACE_GUARANTEE, std::to_string(SpaceGuarantee));
@@ -2894,9 +3346,13 @@ TError TVolume::Restore(const TKeyValue &node) {
     else if (!UserStorage() && !RemoteStorage())
         StoragePath = TStorage(EStorageType::Storage, Place, Storage).Path;
 
-    error = OpenBackend();
-    if (error)
-        return error;
+    return OpenBackend();
+}
+
+TError TVolume::RestoreBackend() {
+    TError error;
+
+    L_ACT("Restore volume {} backend {}", Path, BackendType);
 
     error = Backend->Restore();
     if (error)
@@ -2906,7 +3362,7 @@ TError TVolume::Restore(const TKeyValue &node) {
     if (error)
         return error;
 
-    return OK;
+    return Save();
 }
 
 std::vector<TVolumeProperty> VolumeProperties = {
@@ -2924,6 +3380,9 @@ std::vector<TVolumeProperty> VolumeProperties = {
     { V_PERMISSIONS, "directory permissions (default - 0775)", false },
     { V_CREATOR,     "container user group (ro)", true },
     { V_READ_ONLY,   "true|false (default - false)", false },
+    { V_DIRECT_IO,   "true|false - loop without page cache for image (default - volumes.direct_io_loop)", false },
+    { V_DISCARD,     "true|false - punch holes in loop image for freed blocks (default - false)", false },
+    { V_PREALLOCATE, "true|false - fallocate whole loop image at build (default - false)", false },
     { V_CONTAINERS,  "container [target] [ro] [!];... - initial links (default - self)", false },
     { V_LAYERS,      "top-layer;...;bottom-layer - overlayfs layers", false },
     { V_PLACE,       "place for layers and default storage (optional)", false },
@@ -3027,6 +3486,8 @@ TError TVolume::Create(const TStringMap &cfg, std::shared_ptr<TVolume> &volume)
     if (error)
         return error;
 
+    bool pooled = TakePooledVolume(volume);
+
     /* Add common link */
     auto common_link = std::make_shared<TVolumeLink>(volume, RootContainer);
     common_link->Target = volume->Path;
@@ -3060,7 +3521,7 @@ TError TVolume::Create(const TStringMap &cfg, std::shared_ptr<TVolume> &volume)
     /* release owner */
     CL->ReleaseContainer();
 
-    error = volume->Build();
+    error = pooled ? volume->Adopt() : volume->Build();
     if (error) {
         (void)volume->Destroy();
         return error;
@@ -3112,6 +3573,90 @@ TError TVolume::Create(const TStringMap &cfg, std::shared_ptr<TVolume> &volume)
     return OK;
 }
 
+/*
+ * Backends are restored by pool of threads. Volume is restored only
+ * after all volumes it depends on, cyclic leftovers restored serially.
+ */
+static void RestoreBackends(const std::list<std::shared_ptr<TVolume>> &volumes,
+                            std::set<TVolume *> &failed) {
+    std::map<TVolume *, int> pending;
+    std::queue<std::shared_ptr<TVolume>> ready;
+    std::condition_variable wakeup;
+    std::mutex mutex;
+    int running = 0;
+
+    for (auto &volume: volumes)
+        pending[volume.get()] = 0;
+
+    for (auto &volume: volumes) {
+        for (auto &nested: volume->Nested) {
+            auto it = pending.find(nested.get());
+            if (it != pending.end())
+                it->second++;
+        }
+    }
+
+    for (auto &volume: volumes) {
+        if (!pending[volume.get()])
+            ready.push(volume);
+    }
+
+    auto worker = [&](int index) {
+        SetProcessName(fmt::format("portod-VR{}", index));
+        CL = &SystemClient;
+
+        auto lock = std::unique_lock<std::mutex>(mutex);
+        while (true) {
+            while (ready.empty() && running)
+                wakeup.wait(lock);
+            if (ready.empty())
+                break;
+
+            auto volume = ready.front();
+            ready.pop();
+            running++;
+            lock.unlock();
+
+            TError error = volume->RestoreBackend();
+
+            lock.lock();
+            running--;
+            pending.erase(volume.get());
+            if (error) {
+                L_WRN("Volume {} restore: {}", volume->Path, error);
+                failed.insert(volume.get());
+            }
+            for (auto &nested: volume->Nested) {
+                auto it = pending.find(nested.get());
+                if (it != pending.end() && !--it->second)
+                    ready.push(nested);
+            }
+            wakeup.notify_all();
+        }
+
+        CL = nullptr;
+    };
+
+    int nr_threads = std::min<int>(std::max(config().daemon().io_threads(), 1u), volumes.size());
+    std::vector<std::thread> threads;
+
+    for (int index = 0; index < nr_threads; index++)
+        threads.emplace_back(worker, index);
+    for (auto &thread: threads)
+        thread.join();
+
+    for (auto &volume: volumes) {
+        if (!pending.count(volume.get()))
+            continue;
+        L_WRN("Volume {} has cyclic dependencies", volume->Path);
+        TError error = volume->RestoreBackend();
+        if (error) {
+            L_WRN("Volume {} restore: {}", volume->Path, error);
+            failed.insert(volume.get());
+        }
+    }
+}
+
 void TVolume::RestoreAll(void) {
     std::list<TKeyValue> nodes;
     TError error;
@@ -3141,6 +3686,7 @@ void TVolume::RestoreAll(void) {
     nodes.sort();
 
     std::list<std::shared_ptr<TVolume>> broken_volumes;
+    std::list<std::shared_ptr<TVolume>> restored;
 
     for (auto &node : nodes) {
         if (!node.Name.size())
@@ -3172,15 +3718,21 @@ void TVolume::RestoreAll(void) {
         VolumeLinks[volume->Path] = common_link;
         Statistics->VolumeLinksMounted++;
 
-        error = volume->Save();
+        error = volume->CheckDependencies();
         if (error) {
+            L_WRN("Volume {} has broken dependcies: {}", volume->Path, error);
             broken_volumes.push_back(volume);
             continue;
         }
 
-        error = volume->CheckDependencies();
-        if (error) {
-            L_WRN("Volume {} has broken dependcies: {}", volume->Path, error);
+        restored.push_back(volume);
+    }
+
+    std::set<TVolume *> failed;
+    RestoreBackends(restored, failed);
+
+    for (auto &volume : restored) {
+        if (failed.count(volume.get())) {
             broken_volumes.push_back(volume);
             continue;
         }
@@ -3373,6 +3925,15 @@ TError TVolume::ApplyConfig(const TStringMap &cfg) {
         } else if (prop.first == V_READ_ONLY) {
             error = StringToBool(prop.second, IsReadOnly);
 
+        } else if (prop.first == V_DIRECT_IO) {
+            error = StringToBool(prop.second, DirectIo);
+
+        } else if (prop.first == V_DISCARD) {
+            error = StringToBool(prop.second, Discard);
+
+        } else if (prop.first == V_PREALLOCATE) {
+            error = StringToBool(prop.second, Preallocate);
+
         } else if (prop.first == V_LAYERS) {
             Layers = SplitEscapedString(prop.second, ';');
 
@@ -35,6 +35,9 @@ constexpr const char *V_PERMISSIONS = "permissions";
 constexpr const char *V_STORAGE = "storage";
 constexpr const char *V_LAYERS = "layers";
 constexpr const char *V_READ_ONLY = "read_only";
+constexpr const char *V_DIRECT_IO = "direct_io";
+constexpr const char *V_DISCARD = "discard";
+constexpr const char *V_PREALLOCATE = "preallocate";
 
 constexpr const char *V_SPACE_LIMIT = "space_limit";
 constexpr const char *V_INODE_LIMIT = "inode_limit";
@@ -124,6 +127,11 @@ public:
     int Device = -1;
     bool IsReadOnly = false;
 
+    /* loop backend */
+    bool DirectIo = false;
+    bool Discard = false;
+    bool Preallocate = false;
+
     bool HasDependentContainer = false;
 
     std::vector<std::string> Layers;
@@ -181,6 +189,16 @@ public:
     static TError CheckConflicts(const TPath &path);
 
     TError Build(void);
+    TError InitCred(void);
+    TError Adopt(void);
+
+    bool Poolable() const;
+    std::string PoolKey() const;
+    static void PoolRefill();
+    static std::shared_ptr<TVolume> FindPooledLayer(const TPath &place, const std::string &layer);
+    static void DropPooledLayer(const TPath &place, const std::string &layer);
+    static void StartPool();
+    static void StopPool();
 
     static void DestroyAll();
     TError DestroyOne();
@@ -188,6 +206,7 @@ public:
 
     TError Save(void);
     TError Restore(const TKeyValue &node);
+    TError RestoreBackend(void);
 
     static void RestoreAll(void);
 
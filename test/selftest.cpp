@@ -2511,6 +2511,98 @@ static void TestFormat(Porto::Connection &) {
     Expect(!!StringToSize("1z", v));
 }
 
+static int CountBinaryLog(const TPath &path) {
+    TBinaryLogReader reader;
+    TBinaryLogEntry entry;
+    bool eof = false;
+    int count = 0;
+
+    if (reader.Open(path))
+        return 0;
+    while (!reader.Next(entry, eof) && !eof)
+        count++;
+    return count;
+}
+
+static void TestBinaryLog(Porto::Connection &) {
+    TPath path("/tmp/portotest.binlog");
+    TPath rotated("/tmp/portotest.binlog.1");
+    TBinaryLogReader reader;
+    TBinaryLogEntry entry;
+    bool eof = false;
+
+    (void)path.Unlink();
+    (void)rotated.Unlink();
+
+    OpenBinaryLog(path);
+    StartLogWriter();
+    ExpectEq(BinaryLogActive(), true);
+
+    LogContainerId = 42;
+    LogRequestId = 7;
+    L("binlog {} {} {}", 1, -2, "three");
+    L_WRN("binlog {:.1f}", 0.5);
+
+    /* records must land before rotation */
+    for (int i = 0; i < 100 && CountBinaryLog(path) < 2; i++)
+        usleep(10000);
+    ExpectEq(CountBinaryLog(path), 2);
+
+    /* logrotate and SIGUSR1, format string is already interned */
+    ExpectOk(path.Rename(rotated));
+    OpenBinaryLog(path);
+    LogRequestId = 8;
+    L("binlog {} {} {}", 4, -5, "six");
+
+    StopLogWriter();
+    LogContainerId = 0;
+    LogRequestId = 0;
+    ExpectEq(BinaryLogActive(), false);
+
+    ExpectOk(reader.Open(rotated));
+    ExpectOk(reader.Next(entry, eof));
+    ExpectEq(eof, false);
+    ExpectEq(entry.Text, "binlog 1 -2 three");
+    ExpectEq(entry.ContainerId, 42);
+    ExpectEq(entry.RequestId, 7);
+    ExpectEq(entry.Tid, GetTid());
+    ExpectOk(reader.Next(entry, eof));
+    ExpectEq(eof, false);
+    ExpectEq(entry.Text, "binlog 0.5");
+    ExpectEq(entry.Level, "WRN");
+    ExpectOk(reader.Next(entry, eof));
+    ExpectEq(eof, true);
+
+    /* reopened file is readable alone */
+    ExpectOk(reader.Open(path));
+    ExpectOk(reader.Next(entry, eof));
+    ExpectEq(eof, false);
+    ExpectEq(entry.Text, "binlog 4 -5 six");
+    ExpectEq(entry.ContainerId, 42);
+    ExpectEq(entry.RequestId, 8);
+    ExpectOk(reader.Next(entry, eof));
+    ExpectEq(eof, true);
+
+    /* filters */
+    reader.Level = "WRN";
+    ExpectOk(reader.Open(rotated));
+    ExpectOk(reader.Next(entry, eof));
+    ExpectEq(eof, false);
+    ExpectEq(entry.Text, "binlog 0.5");
+    ExpectOk(reader.Next(entry, eof));
+    ExpectEq(eof, true);
+
+    reader.Level = "";
+    reader.RequestId = 7;
+    ExpectOk(reader.Open(path));
+    ExpectOk(reader.Next(entry, eof));
+    ExpectEq(eof, true);
+
+    reader.Close();
+    ExpectOk(path.Unlink());
+    ExpectOk(rotated.Unlink());
+}
+
 static void TestRoot(Porto::Connection &api) {
     string v;
     string root = "/";
@@ -4585,6 +4677,7 @@ int SelfTest(std::vector<std::string> args) {
         { "path", TestPath },
         { "idmap", TestIdmap },
         { "format", TestFormat },
+        { "binlog", TestBinaryLog },
         { "root", TestRoot },
         { "data", TestData },
         { "holder", TestHolder },
@@ -8,6 +8,7 @@
 
 #include "config.hpp"
 #include "util/string.hpp"
+#include "util/unix.hpp"
 #include "test.hpp"
 
 extern "C" {
@@ -89,13 +90,18 @@ static void SetProperty(Porto::Connection &api, std::string name, std::string ty
     ExpectEq(res_value, value);
 }
 
+static std::atomic<uint64_t> StartCount(0), StartTimeMs(0);
+
 static void Start(Porto::Connection &api, std::string name) {
     std::string pid;
     std::string ret;
 
     Say() << "Start container: " << name << std::endl;
 
+    uint64_t time = GetCurrentTimeMs();
     (void)api.Start(name);
+    StartTimeMs += GetCurrentTimeMs() - time;
+    StartCount++;
     ExpectApiSuccess(api.GetData(name, "state", ret));
     Expect(ret == "dead" || ret == "running");
 }
@@ -263,18 +269,25 @@ int StressTest(int threads, int iter, bool killPorto) {
     ReadConfigs();
     Porto::Connection api;
 
+    uint64_t time = GetCurrentTimeMs();
     for (i = 1; i <= threads; i++)
         thrTasks.push_back(std::thread(Tasks, i, iter));
     if (killPorto)
         thrKill = std::thread(StressKill);
     for (auto& th : thrTasks)
         th.join();
+    time = GetCurrentTimeMs() - time;
     done++;
     if (killPorto)
         thrKill.join();
 
     TestDaemon(api);
 
+    if (StartCount)
+        std::cout << "Started " << StartCount << " containers, "
+                  << StartTimeMs / StartCount << " ms avg, "
+                  << StartCount * 1000 / std::max(time, (uint64_t)1) << " starts/s" << std::endl;
+
     std::cout << "Test completed!" << std::endl;
 
     return 0;
@@ -2,6 +2,10 @@ from test_common import *
 
 import sys
 import os
+import socket
+import signal
+import tarfile
+import zlib
 import porto
 
 AsAlice()
@@ -133,11 +137,111 @@ a.Start()
 assert a.Wait() == a.name
 assert a.GetData("exit_status") == "0"
 assert a.GetData("stdout") == "test\n"
+
+if hasattr(socket.socket, 'recvmsg'):
+    fd, offset = a.OpenStream("stdout")
+    assert offset == 0
+    assert os.read(fd, 100) == b"test\n"
+    os.close(fd)
+    assert Catch(a.OpenStream, "stdin") == porto.exceptions.InvalidValue
+
+a.Stop()
+if hasattr(socket.socket, 'recvmsg'):
+    assert Catch(a.OpenStream, "stdout") == porto.exceptions.InvalidState
+
+# EXIT VIA PIDFD
+
+def HasPidfd():
+    import ctypes
+    libc = ctypes.CDLL(None, use_errno=True)
+    fd = libc.syscall(434, os.getpid(), 0) # pidfd_open
+    if fd < 0:
+        return False
+    os.close(fd)
+    return True
+
+def Reaped(pid):
+    try:
+        return not IsZombie(pid)
+    except (IOError, OSError):
+        return True
+
+pidfd_exits = int(c.GetProperty("/", "porto_stat[pidfd_exits]"))
+a.SetProperty("command", "sh -c 'sleep 0.5; exit 3'")
+for i in range(5):
+    a.Start()
+    pid = int(a.GetData("root_pid"))
+    assert a.Wait() == a.name
+    assert a.GetData("exit_status") == "768"
+    a.Stop()
+    # pidfd exit acks master with -pid, zombie must be reaped anyway
+    for j in range(50):
+        if Reaped(pid):
+            break
+        time.sleep(0.1)
+    assert Reaped(pid)
+if HasPidfd():
+    assert int(c.GetProperty("/", "porto_stat[pidfd_exits]")) > pidfd_exits
 c.Destroy(a)
 
 assert Catch(c.Find, container_name) == porto.exceptions.ContainerDoesNotExist
 assert not container_name in c.List()
 
+# BATCH START
+
+a = c.Create(container_name)
+b = [c.Create(container_name + "/" + str(i)) for i in range(4)]
+for ct in b:
+    ct.SetProperty("command", "sleep 60")
+res = c.StartBatch([container_name], subtree=True)
+assert res == dict([(ct.name, None) for ct in [a] + b])
+assert a.GetData("state") == "meta"
+for ct in b:
+    assert ct.GetData("state") == "running"
+
+res = c.StartBatch([b[0].name, container_name + "/missing"])
+assert isinstance(res[b[0].name], porto.exceptions.InvalidState)
+assert isinstance(res[container_name + "/missing"], porto.exceptions.ContainerDoesNotExist)
+
+a.Stop()
+b[0].SetProperty("command", "sleep 60")
+res = c.StartBatch([b[1].name, b[0].name])
+assert res == {b[1].name: None, b[0].name: None}
+assert a.GetData("state") == "meta"
+
+# BATCH STOP AND DESTROY
+
+res = c.StopBatch([b[0].name, container_name])
+assert res == {container_name: None, b[0].name: None}
+for ct in [a] + b:
+    assert ct.GetData("state") == "stopped"
+
+res = c.DestroyBatch([b[2].name, container_name + "/missing"])
+assert res[b[2].name] is None
+assert isinstance(res[container_name + "/missing"], porto.exceptions.ContainerDoesNotExist)
+assert Catch(c.Find, b[2].name) == porto.exceptions.ContainerDoesNotExist
+
+c.StartBatch([container_name], subtree=True)
+res = c.DestroyBatch([container_name, b[1].name])
+assert res == {container_name: None, b[1].name: None}
+assert Catch(c.Find, container_name) == porto.exceptions.ContainerDoesNotExist
+
+# BATCH START CHECKS EACH CONTAINER IN SUBTREE
+
+a = c.Create(container_name)
+AsRoot()
+r = porto.Connection()
+b = r.Create(container_name + "/foreign")
+b.SetProperty("owner_user", "porto-bob")
+b.SetProperty("command", "sleep 60")
+AsAlice()
+res = c.StartBatch([container_name], subtree=True)
+assert res[a.name] is None
+assert isinstance(res[b.name], porto.exceptions.PermissionError)
+assert b.GetData("state") == "stopped"
+r.Destroy(a)
+r.Disconnect()
+
 a = c.Run(container_name, command="sleep 5", private_value=volume_private)
 assert a["command"] == "sleep 5"
 assert a["private"] == volume_private
@@ -154,11 +258,85 @@ f = open(v.path + "/file", 'w')
 f.write("test")
 f.close()
 
+helpers_started = int(c.GetProperty("/", "porto_stat[helpers_started]"))
+helpers_cpu = int(c.GetProperty("/", "porto_stat[helpers_cpu_usage_ms]"))
+
 v.Export(tarball_path)
 l = c.ImportLayer(layer_name, tarball_path)
 assert l.name == layer_name
+
+assert int(c.GetProperty("/", "porto_stat[helpers_started]")) >= helpers_started + 2
 assert c.FindLayer(layer_name).name == layer_name
 
+# helper stderr goes into error
+bad_tarball_path = "/tmp/" + prefix + "bad.tgz"
+open(bad_tarball_path, 'w').write("garbage")
+try:
+    c.ImportLayer(layer_name + "-bad", bad_tarball_path)
+    assert False
+except porto.exceptions.PortoException as e:
+    assert len(str(e).split(" stderr: ", 1)[1].strip()) > 0
+os.unlink(bad_tarball_path)
+
+# helper is killed when client is gone
+
+def GzipMember(data):
+    z = zlib.compressobj(1, zlib.DEFLATED, 31)
+    return z.compress(data) + z.flush()
+
+def HelperPids():
+    return set(open("/sys/fs/cgroup/memory/portod-helpers/cgroup.procs").read().split())
+
+# concatenated gzip members: 16G of zeros in a few megabytes
+big_tarball_path = "/tmp/" + prefix + "big.tgz"
+with open(big_tarball_path, 'wb') as f:
+    info = tarfile.TarInfo("big")
+    info.size = 16 << 30
+    f.write(GzipMember(info.tobuf(tarfile.GNU_FORMAT)))
+    zeros = GzipMember(b"\0" * (64 << 20))
+    for i in range(info.size >> 26):
+        f.write(zeros)
+    f.write(GzipMember(b"\0" * 1024))
+
+helpers_canceled = int(c.GetProperty("/", "porto_stat[helpers_canceled]"))
+helpers = HelperPids()
+
+pid = os.fork()
+if not pid:
+    try:
+        porto.Connection().ImportLayer(layer_name + "-big", big_tarball_path)
+    finally:
+        os._exit(0)
+
+for i in range(100):
+    if HelperPids() - helpers:
+        break
+    time.sleep(0.1)
+assert HelperPids() - helpers
+time.sleep(1)
+os.kill(pid, signal.SIGKILL)
+os.waitpid(pid, 0)
+
+for i in range(100):
+    if not HelperPids() - helpers:
+        break
+    time.sleep(0.1)
+assert not HelperPids() - helpers
+assert int(c.GetProperty("/", "porto_stat[helpers_canceled]")) > helpers_canceled
+assert int(c.GetProperty("/", "porto_stat[helpers_cpu_usage_ms]")) > helpers_cpu
+assert Catch(c.FindLayer, layer_name + "-big") == porto.exceptions.LayerNotFound
+os.unlink(big_tarball_path)
+
+if os.access("/usr/bin/zstd", os.X_OK):
+    zst_tarball_path = "/tmp/" + prefix + "layer.tar.zst"
+    v.Export(zst_tarball_path)
+    zl = c.ImportLayer(layer_name + "-zst", zst_tarball_path)
+    os.unlink(zst_tarball_path)
+    w = c.CreateVolume(layers=[zl.name])
+    assert open(w.path + "/file").read() == "test"
+    w.Unlink()
+    zl.Remove()
+
 assert l.GetPrivate() == ""
 l.SetPrivate("123654")
 assert l.GetPrivate() == "123654"
@@ -170,6 +348,10 @@ assert l.owner_user == "porto-alice"
 assert l.owner_group == "porto-alice"
 assert l.last_usage >= 0
 assert l.private_value == "AbC"
+assert l.space_used is None
+
+sl = c.ListLayers(mask=layer_name, space_usage=True)[0]
+assert sl.space_used + sl.space_shared > 0
 
 assert Catch(c.GetLayerPrivate, "my1980") == porto.exceptions.LayerNotFound
 assert Catch(c.SetLayerPrivate, "my1980", "my1980") == porto.exceptions.LayerNotFound
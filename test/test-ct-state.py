@@ -141,6 +141,27 @@ ExpectEq(a["stdout[:10]"], "4095\n4096\n")
 ExpectEq(a["stderr"], "")
 a.Stop()
 
+# stdout is rotated while task is running
+a["command"] = "sh -c 'seq 200000; sleep 1000'"
+a["stdout_limit"] = "65536"
+a.Start()
+time.sleep(3)
+ExpectEq(a["state"], "running")
+ExpectNe(a["stdout_offset"], "0")
+ExpectLe(len(a["stdout"]), 65536)
+a.Stop()
+
+# burst after long idle is rotated within log_rotate_ms
+a["command"] = "sh -c 'sleep 12; seq 200000; sleep 1000'"
+a.Start()
+time.sleep(11)
+ExpectEq(a["stdout_offset"], "0")
+time.sleep(3)
+ExpectEq(a["state"], "running")
+ExpectNe(a["stdout_offset"], "0")
+ExpectLe(len(a["stdout"]), 65536)
+a.Stop()
+
 a["command"] = "__non_existing_command__"
 ExpectEq(Catch(a.Start), porto.exceptions.InvalidCommand)
 ExpectEq(a["state"], "stopped")
@@ -1,6 +1,7 @@
 #!/usr/bin/python
 
 import subprocess
+import json
 import resource
 import porto
 import time
@@ -381,3 +382,89 @@ if __name__ == '__main__':
 
         Expect(not regression_create)
         Expect(not regression_destroy)
+
+    print "\nLayer import throughput\n"
+
+    LAYER_MB = 512
+    tmpdir = "/tmp/" + NAME
+    layer_dir = tmpdir + "/layer"
+
+    subprocess.call(["rm", "-rf", tmpdir])
+    os.makedirs(layer_dir)
+
+    # Half random, half compressible data in files of 4M
+    for i in range(0, LAYER_MB / 4):
+        src = "/dev/urandom" if i % 2 else "/dev/zero"
+        subprocess.check_call(["dd", "if=" + src, "of={}/file{}".format(layer_dir, i),
+                               "bs=1M", "count=4", "status=none"])
+
+    c = porto.Connection(timeout=600)
+
+    print "{:>8}, {:>10}, {:>10}".format("format", "time", "MB/s")
+
+    # Multi-block xz is the only format decompressed in parallel
+    for (ext, opt) in [("tar", ""), ("tgz", "-z"), ("txz", "-J"),
+                       ("txz-mt", "--use-compress-program=xz -T0"),
+                       ("tzst", "--zstd")]:
+        tarball = "{}/layer.{}".format(tmpdir, ext.split("-")[0])
+        args = ["tar", "-cf", tarball, "-C", layer_dir, "."]
+        if opt:
+            args.insert(1, opt)
+        subprocess.check_call(args)
+
+        layer = NAME + "-" + ext
+        (t, _) = measure_time(c.ImportLayer)(layer, tarball)
+        c.RemoveLayer(layer)
+        os.unlink(tarball)
+
+        print "{:>8}, {:10.3f}, {:10.1f}".format(ext, t, LAYER_MB / t)
+
+        ExpectLe(t, 300, "{} layer import time above 300 s ".format(ext))
+
+    subprocess.call(["rm", "-rf", tmpdir])
+
+    print "\nVolume removal with many inodes\n"
+
+    print "{:>10}, {:>10}, {:>10}".format("inodes", "time", "inodes/s")
+
+    for (dirs, files) in [(100, 1000), (1000, 1000)]:
+        v = c.CreateVolume(backend="native")
+
+        for d in range(dirs):
+            path = "{}/dir{}".format(v.path, d)
+            os.mkdir(path)
+            for f in range(files):
+                os.close(os.open("{}/file{}".format(path, f), os.O_CREAT | os.O_WRONLY, 0644))
+
+        inodes = dirs * (files + 1)
+        (t, _) = measure_time(v.Unlink)()
+
+        print "{:>10}, {:10.3f}, {:10.0f}".format(inodes, t, inodes / t)
+
+        ExpectLe(t, 300, "removal of {} inodes above 300 s ".format(inodes))
+
+    print "\nLoop volume random writes\n"
+
+    if subprocess.call(["which", "fio"], stdout=open(os.devnull, "w")) == 0:
+        print "{:>10}, {:>10}, {:>10}, {:>10}".format("direct_io", "iops", "p99 ms", "cached MB")
+
+        def cached():
+            return int([l.split()[1] for l in open("/proc/meminfo") if l.startswith("Cached:")][0]) >> 10
+
+        for direct_io in ["false", "true"]:
+            v = c.CreateVolume(backend="loop", space_limit="2G",
+                               direct_io=direct_io, preallocate="true")
+
+            before = cached()
+            out = subprocess.check_output(["fio", "--name=randwrite", "--filename=" + v.path + "/fio",
+                                           "--size=1G", "--rw=randwrite", "--bs=4k", "--ioengine=psync",
+                                           "--fsync=32", "--runtime=30", "--time_based",
+                                           "--output-format=json"])
+            job = json.loads(out)["jobs"][0]["write"]
+            p99 = job["clat_ns"]["percentile"]["99.000000"] / 1e6
+
+            print "{:>10}, {:10.0f}, {:10.3f}, {:10}".format(direct_io, job["iops"], p99, cached() - before)
+
+            v.Unlink()
+    else:
+        print "fio not found, skipped"
@@ -35,5 +35,19 @@ test.Destroy()
 for link in managed_links:
     assert has_qdisc(link)
 
+# statistics of container network keep going after repair
+a = conn.Run('a', net='L3 veth', command='ping6 -i 0.2 -n ff02::1%veth')
+pid = a.GetProperty('root_pid')
+subprocess.check_call(['nsenter', '-t', pid, '-n', 'tc', 'qdisc', 'del', 'root', 'dev', 'veth'])
+subprocess.check_call(['nsenter', '-t', pid, '-n', 'ip', 'link', 'add', 'dummy0', 'type', 'dummy'])
+time.sleep(1)
+prev = int(conn.Get(['a'], ['net_tx_packets[Uplink]'], sync=True)['a']['net_tx_packets[Uplink]'])
+for i in range(3):
+    time.sleep(1)
+    cur = int(conn.Get(['a'], ['net_tx_packets[Uplink]'], sync=True)['a']['net_tx_packets[Uplink]'])
+    assert cur > prev
+    prev = cur
+a.Destroy()
+
 ExpectEq(int(conn.GetData('/', 'porto_stat[errors]')), expected_errors)
 ExpectEq(int(conn.GetData('/', 'porto_stat[warnings]')), expected_warnings)
@@ -0,0 +1,105 @@
+#!/usr/bin/python
+
+import os
+import time
+import shutil
+import tarfile
+import porto
+from test_common import *
+
+DIR = "/tmp/test-volume-pool"
+LAYER = "test-volume-pool"
+CONF = "/etc/portod.conf.d/test-volume-pool.conf"
+
+def Stat(c, name):
+    return int(c.GetData('/', 'porto_stat[{}]'.format(name)))
+
+def WaitPooled(c, count):
+    for i in range(300):
+        if Stat(c, 'volumes_pooled') == count:
+            return
+        time.sleep(0.1)
+    ExpectEq(Stat(c, 'volumes_pooled'), count)
+
+AsRoot()
+
+c = porto.Connection()
+
+Catch(shutil.rmtree, DIR)
+os.mkdir(DIR)
+open(DIR + "/file.txt", "w").write("pool")
+t = tarfile.open(name=DIR + "/layer.tar", mode="w")
+t.add(DIR + "/file.txt", arcname="file.txt")
+t.close()
+
+Catch(c.RemoveLayer, LAYER)
+c.ImportLayer(LAYER, DIR + "/layer.tar")
+
+open(CONF, "w").write("""
+volumes {
+    pool {
+        backend: "overlay"
+        layers: "%s"
+        size: 2
+    }
+}
+""" % LAYER)
+
+try:
+    ReloadPortod()
+    c = porto.Connection()
+
+    WaitPooled(c, 2)
+
+    # pre-built volumes are not listed
+    ExpectEq(len([v for v in c.ListVolumes() if v.GetProperties().get("layers") == LAYER]), 0)
+
+    # different configuration is built as usual
+    hits = Stat(c, 'volume_pool_hits')
+    v = c.CreateVolume(backend="plain", layers=[LAYER])
+    ExpectEq(Stat(c, 'volume_pool_hits'), hits)
+    ExpectEq(Stat(c, 'volumes_pooled'), 2)
+    v.Unlink()
+
+    # adopted volume takes owner and permissions of requester
+    AsAlice()
+    c = porto.Connection()
+    hits = Stat(c, 'volume_pool_hits')
+    v = c.CreateVolume(backend="overlay", layers=[LAYER], permissions="0750")
+    ExpectEq(Stat(c, 'volume_pool_hits'), hits + 1)
+    ExpectEq(v.GetProperty("owner_user"), "porto-alice")
+    ExpectEq(v.GetProperty("user"), "porto-alice")
+    ExpectEq(v.GetProperty("permissions"), "0750")
+    ExpectEq(v.GetProperty("layers"), LAYER)
+    st = os.stat(v.path)
+    ExpectEq(st.st_uid, alice_uid)
+    ExpectEq(st.st_gid, alice_gid)
+    ExpectEq(st.st_mode & 0777, 0750)
+    ExpectEq(open(v.path + "/file.txt").read(), "pool")
+    open(v.path + "/new.txt", "w").write("new")
+    path = v.path
+    AsRoot()
+    c = porto.Connection()
+
+    # pool is refilled after take
+    WaitPooled(c, 2)
+    ExpectEq(c.FindVolume(path).GetProperty("owner_user"), "porto-alice")
+
+    c.FindVolume(path).Unlink()
+
+    # layer removal drops pre-built volumes, refill may race in one more
+    for i in range(10):
+        if Catch(c.RemoveLayer, LAYER) != porto.exceptions.Busy:
+            break
+        time.sleep(0.5)
+    ExpectEq(Catch(c.FindLayer, LAYER), porto.exceptions.LayerNotFound)
+    ExpectEq(Stat(c, 'volumes_pooled'), 0)
+
+finally:
+    os.unlink(CONF)
+    ReloadPortod()
+    c = porto.Connection()
+    Catch(c.RemoveLayer, LAYER)
+    shutil.rmtree(DIR)
+
+ExpectEq(Stat(c, 'volumes_pooled'), 0)
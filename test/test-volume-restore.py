@@ -15,3 +15,39 @@ ReloadPortod()
 ExpectEq(Catch(c.Find, "a"), porto.exceptions.ContainerDoesNotExist)
 c.FindVolume(v.path)
 v.Unlink()
+
+# nested volumes are restored after their parents, others in parallel
+lost = int(c.GetData('/', 'porto_stat[volume_lost]'))
+a = c.Run("a", weak=False)
+
+base = c.CreateVolume(backend="plain", containers="a")
+os.mkdir(base.path + "/nested")
+nested = c.CreateVolume(base.path + "/nested", backend="plain", containers="a")
+os.mkdir(nested.path + "/tmpfs")
+tmpfs = c.CreateVolume(nested.path + "/tmpfs", backend="tmpfs", space_limit="1M", containers="a")
+open(tmpfs.path + "/file", "w").write("tmpfs")
+os.mkdir(nested.path + "/layer")
+open(nested.path + "/layer/file", "w").write("layer")
+overlay = c.CreateVolume(backend="overlay", layers=[nested.path + "/layer"], containers="a")
+flat = [c.CreateVolume(backend="plain", containers="a") for i in range(8)]
+for v in flat:
+    open(v.path + "/file", "w").write(v.path)
+
+volumes = [base, nested, tmpfs, overlay] + flat
+ReloadPortod()
+
+ExpectEq(int(c.GetData('/', 'porto_stat[volume_lost]')), lost)
+for v in volumes:
+    ExpectEq(c.FindVolume(v.path).GetProperty("state"), "ready")
+ExpectEq(open(tmpfs.path + "/file").read(), "tmpfs")
+ExpectEq(open(overlay.path + "/file").read(), "layer")
+for v in flat:
+    ExpectEq(open(v.path + "/file").read(), v.path)
+
+mounts = ParseMountinfo()
+ExpectEq(mounts[tmpfs.path]['parent_id'], mounts[nested.path]['mount_id'])
+ExpectEq(mounts[nested.path]['parent_id'], mounts[base.path]['mount_id'])
+
+a.Destroy()
+for v in volumes:
+    ExpectEq(Catch(c.FindVolume, v.path), porto.exceptions.VolumeNotFound)
@@ -8,7 +8,9 @@ import struct
 import shutil
 import tarfile
 import subprocess
+import threading
 import traceback
+from distutils.spawn import find_executable
 
 import porto
 from test_common import *
@@ -545,9 +547,103 @@ def backend_loop(c):
     assert Catch(c.CreateVolume, **args) == porto.exceptions.Busy
     v.Unlink("/")
 
+    v = c.CreateVolume(backend="loop", storage=os.path.abspath(DIR + "/loop.img"), preallocate="true")
+    assert os.stat(DIR + "/loop.img").st_blocks * 512 >= 512 * 1048576
+    v.Unlink("/")
+
     os.unlink(DIR + "/loop.img")
+
+    v = c.CreateVolume(backend="loop", space_limit="512M",
+                       direct_io="true", discard="true", preallocate="true")
+    assert v.GetProperty("direct_io") == "true"
+    assert v.GetProperty("discard") == "true"
+    assert v.GetProperty("preallocate") == "true"
+    mnt = [l.split() for l in open("/proc/self/mountinfo") if l.split()[4] == v.path][0]
+    dev, opts = mnt[-2], mnt[-1].split(",")
+    assert "discard" in opts
+    assert open("/sys/block/" + os.path.basename(dev) + "/loop/dio").read().strip() == "1"
+    image = os.stat(v.path + "/../loop/loop.img")
+    assert image.st_blocks * 512 >= 512 * 1048576
+    v.Unlink("/")
+
+    assert Catch(c.CreateVolume, backend="native", direct_io="true") == porto.exceptions.InvalidProperty
+    assert Catch(c.CreateVolume, backend="plain", preallocate="true") == porto.exceptions.InvalidProperty
+
+    # parallel creation takes distinct devices from pool
+    volumes = []
+    def create_loop():
+        volumes.append(porto.Connection().CreateVolume(backend="loop", space_limit="64M"))
+    threads = [threading.Thread(target=create_loop) for i in range(4)]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    assert len(volumes) == 4
+    devs = set([ParseMountinfo()[v.path]['source'] for v in volumes])
+    assert len(devs) == 4
+    for v in volumes:
+        c.FindVolume(v.path).Unlink("/")
+    for dev in devs:
+        assert not LoopBound(dev)
+
+    # detached devices return to pool and are reused
+    devs = set()
+    for i in range(8):
+        v = c.CreateVolume(backend="loop", space_limit="64M")
+        devs.add(ParseMountinfo()[v.path]['source'])
+        v.Unlink("/")
+    assert len(devs) <= 2
+
     os.rmdir(TMPDIR)
 
+def SquashLoops(image):
+    loops = set()
+    for m in ParseMountinfo().values():
+        if m['type'] == 'squashfs' and m['source'].startswith('/dev/loop'):
+            loop = "/sys/block/" + os.path.basename(m['source']) + "/loop/backing_file"
+            if os.path.exists(loop) and open(loop).read().strip() == image:
+                loops.add(m['source'])
+    return loops
+
+def LoopBound(dev):
+    return os.path.exists("/sys/block/" + os.path.basename(dev) + "/loop/backing_file")
+
+def backend_squash(c):
+    if not find_executable("mksquashfs"):
+        return
+
+    image = DIR + "/squash.img"
+    os.mkdir(DIR + "/squash")
+    open(DIR + "/squash/file.txt", "w").write("squash")
+    subprocess.check_call(["mksquashfs", DIR + "/squash", image, "-noappend", "-quiet"])
+
+    # volumes of one image share loop device
+    a = c.CreateVolume(backend="squash", layers=[image])
+    b = c.CreateVolume(backend="squash", layers=[image])
+    assert open(a.path + "/file.txt").read() == "squash"
+    assert open(b.path + "/file.txt").read() == "squash"
+    loops = SquashLoops(image)
+    assert len(loops) == 1
+    dev = list(loops)[0]
+
+    # device is kept while any volume uses it
+    a.Unlink("/")
+    assert LoopBound(dev)
+    assert SquashLoops(image) == loops
+
+    # refcount survives restart
+    ReloadPortod()
+    a = c.CreateVolume(backend="squash", layers=[image])
+    assert SquashLoops(image) == loops
+    c.FindVolume(b.path).Unlink("/")
+    assert LoopBound(dev)
+    a.Unlink("/")
+    assert len(SquashLoops(image)) == 0
+    assert not LoopBound(dev)
+
+    os.unlink(image)
+    shutil.rmtree(DIR + "/squash")
+
 def backend_rbd():
     #Not implemented yet
     pass
@@ -580,6 +676,7 @@ def TestBody(c):
     backend_native(c)
     backend_overlay(c)
     backend_loop(c)
+    backend_squash(c)
 
     c.RemoveLayer("test-volumes")
     assert len(c.ListVolumes()) == 0
@@ -107,11 +107,20 @@ def Test():
 
     v.Unlink()
 
+    reclaimed = int(c.GetProperty("/", "porto_stat[remove_reclaimed]"))
+
     c.RemoveLayer("place-ubuntu-precise", place=PLACE_DIR)
 
     assert len(os.listdir(PLACE_DIR + "/porto_volumes")) == 0
     assert len(c.ListLayers(place=PLACE_DIR)) == 0
+
+    # layer data is reclaimed in background
+    for i in range(300):
+        if not os.listdir(PLACE_DIR + "/porto_layers"):
+            break
+        time.sleep(0.1)
     assert len(os.listdir(PLACE_DIR + "/porto_layers")) == 0
+    assert int(c.GetProperty("/", "porto_stat[remove_reclaimed]")) > reclaimed
 
 
 ret = 0